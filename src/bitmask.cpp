@@ -14,16 +14,32 @@ namespace pvxs {
 
 
 BitMask::BitMask(BitMask&& o) noexcept
-    :_words(std::move(o._words))
-    ,_size(o._size)
 {
-    o._size = 0u;
+    *this = std::move(o);
 }
 
 BitMask& BitMask::operator=(BitMask&& o) noexcept
 {
-    _words = std::move(o._words);
+    if(this==&o)
+        return *this;
+
+    if(_onheap())
+        delete[] _words;
+
+    if(o._onheap()) {
+        // steal
+        _words = o._words;
+        _wcap = o._wcap;
+        o._words = o._inline;
+        o._wcap = _ninline;
+    } else {
+        _words = _inline;
+        _wcap = _ninline;
+        std::copy(o._inline, o._inline+o._wsize, _inline);
+    }
+    _wsize = o._wsize;
     _size = o._size;
+    o._wsize = 0u;
     o._size = 0u;
     return *this;
 }
@@ -43,48 +59,21 @@ BitMask::BitMask(std::initializer_list<size_t> bits, size_t nbits)
 
 void BitMask::resize(size_t bits) {
     // round up to multiple of 64
-    size_t storebits = ((bits-1u)|0x3f)+1u;
-    _words.resize(storebits/64u, 0u);
-    _size = uint16_t(bits);
-}
-
-size_t BitMask::findSet(size_t start) const
-{
-    while(start < _size) {
-        size_t word = start/64u,
-                bit = start%64u;
-
-        // first see if we can skip to next word
-        uint64_t mask = ~((1ull<<bit)-1); // mask of bit and higher
-        uint64_t masked = _words[word]&mask;
-        if(masked==0u) {
-            start = (word+1u)*64u;
-            continue;
-        }
-
-        // the answer is in range [bit, 64)
-
-        // count consecutive "trailing" zeros.
-        // http://graphics.stanford.edu/~seander/bithacks.html#ZerosOnRightParallel
-
-        masked &= -masked; // and with two's complement.  neat.  clears all except the bit we care about
-
-        // now a binary search
-        // we know masked is non-zero, and can start from 63
-        //bit = 64u;
-        //if(masked) bit--;
-        bit = 63u;
-        if(masked&0x00000000ffffffffull) bit -= 32u;
-        if(masked&0x0000ffff0000ffffull) bit -= 16u;
-        if(masked&0x00ff00ff00ff00ffull) bit -= 8u;
-        if(masked&0x0f0f0f0f0f0f0f0full) bit -= 4u;
-        if(masked&0x3333333333333333ull) bit -= 2u; // 0xb0011 repeated
-        if(masked&0x5555555555555555ull) bit -= 1u; // 0xb0101 repeated
-
-        return (word*64u) | bit;
+    size_t nwords = bits ? (bits+63u)/64u : 0u;
+
+    if(nwords > _wcap) {
+        auto next = new uint64_t[nwords];
+        std::copy(_words, _words+_wsize, next);
+        if(_onheap())
+            delete[] _words;
+        _words = next;
+        _wcap = uint16_t(nwords);
     }
+    if(nwords > _wsize)
+        std::fill(_words+_wsize, _words+nwords, 0u);
 
-    return _size;
+    _wsize = uint16_t(nwords);
+    _size = uint16_t(bits);
 }
 
 std::ostream& operator<<(std::ostream& strm, const BitMask& mask)
@@ -105,9 +94,9 @@ bool operator==(const BitMask& lhs, const BitMask& rhs)
     if(lhs.size()!=rhs.size())
         return false;
 
-    return std::equal(lhs._words.begin(),
-                      lhs._words.end(),
-                      rhs._words.begin());
+    return std::equal(lhs._words,
+                      lhs._words+lhs._wsize,
+                      rhs._words);
 }
 
 namespace impl {
@@ -135,9 +124,8 @@ void to_wire(Buffer& buf, const BitMask& mask)
     size_t nbytes = nwords*8u + extra;
 
     to_wire(buf, Size{nbytes});
-    for(auto i : range(nwords)) {
-        to_wire(buf, mask.word(i));
-    }
+    if(nwords)
+        _to_wire_bulk(buf, reinterpret_cast<const uint8_t*>(&mask.word(0)), 8u, nwords, buf.be ^ hostBE);
     if(extra) {
         uint64_t last = mask.word(nwords);
         for(auto i : range(extra)) {
@@ -157,9 +145,8 @@ void from_wire(Buffer& buf, BitMask& mask)
     size_t nwords = nbytes.size / 8u;
     size_t extra = nbytes.size % 8u; // trailing single bytes
 
-    for(auto i : range(nwords)) {
-        from_wire(buf, mask.word(i));
-    }
+    if(nwords)
+        _from_wire_bulk(buf, reinterpret_cast<uint8_t*>(&mask.word(0)), 8u, nwords, buf.be ^ hostBE);
     if(extra) {
         uint64_t& last = mask.word(nwords);
         for(auto i : range(extra)) {
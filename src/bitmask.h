@@ -12,11 +12,61 @@
 #include <algorithm>
 #include <cstdint>
 
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+#  include <intrin.h>
+#endif
+
 #include <pvxs/version.h>
 
 namespace pvxs {
 
 namespace detail {
+//! Index of the least significant set bit.  v must be non-zero.
+inline
+unsigned ctz64(uint64_t v)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return unsigned(__builtin_ctzll(v)); // tzcnt/bsf
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+    unsigned long ret;
+    _BitScanForward64(&ret, v);
+    return unsigned(ret);
+#else
+    // count consecutive "trailing" zeros.
+    // http://graphics.stanford.edu/~seander/bithacks.html#ZerosOnRightParallel
+
+    v &= -v; // and with two's complement.  neat.  clears all except the bit we care about
+
+    // now a binary search
+    // we know v is non-zero, and can start from 63
+    unsigned bit = 63u;
+    if(v&0x00000000ffffffffull) bit -= 32u;
+    if(v&0x0000ffff0000ffffull) bit -= 16u;
+    if(v&0x00ff00ff00ff00ffull) bit -= 8u;
+    if(v&0x0f0f0f0f0f0f0f0full) bit -= 4u;
+    if(v&0x3333333333333333ull) bit -= 2u; // 0xb0011 repeated
+    if(v&0x5555555555555555ull) bit -= 1u; // 0xb0101 repeated
+    return bit;
+#endif
+}
+
+//! Number of set bits
+inline
+unsigned popcount64(uint64_t v)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return unsigned(__builtin_popcountll(v));
+#elif defined(_MSC_VER) && defined(_M_X64)
+    return unsigned(__popcnt64(v));
+#else
+    // http://graphics.stanford.edu/~seander/bithacks.html#CountBitsSetParallel
+    v = v - ((v >> 1) & 0x5555555555555555ull);
+    v = (v & 0x3333333333333333ull) + ((v >> 2) & 0x3333333333333333ull);
+    v = (v + (v >> 4)) & 0x0f0f0f0f0f0f0f0full;
+    return unsigned((v * 0x0101010101010101ull) >> 56);
+#endif
+}
+
 // base type, defines operations which can be performed on an BitMask expression
 template <typename Sub>
 struct BitBase {
@@ -89,14 +139,23 @@ operator |(const BitBase<Lhs>& lhs, const BitBase<Rhs>& rhs)
 } // namespace detail
 
 class BitMask : public detail::BitBase<BitMask> {
+    // number of words stored without a heap allocation.  (128 bits)
+    static constexpr size_t _ninline = 2u;
     // bit  0 - lsb of word 0
     // bit 63 - msb of word 0
     // bit 64 - lsb of word 1
-    std::vector<uint64_t> _words;
+    uint64_t _inline[_ninline];
+    // either _inline, or heap allocated with capacity _wcap
+    uint64_t* _words = _inline;
+    // words in use.  _wsize*64u >= _size
+    uint16_t _wsize=0u;
+    // capacity of _words
+    uint16_t _wcap=_ninline;
     // actual size in bits
-    // _words.size()*64u >= _size
     uint16_t _size=0u;
 
+    inline bool _onheap() const { return _words!=_inline; }
+
 public:
 
     typedef bool value_type;
@@ -108,7 +167,10 @@ public:
     BitMask(BitMask&&) noexcept;
     BitMask& operator=(const BitMask&) = delete;
     BitMask& operator=(BitMask&&) noexcept;
-    ~BitMask() = default;
+    ~BitMask() {
+        if(_onheap())
+            delete[] _words;
+    }
 
     //! cleared mask with size()==0
     explicit BitMask(size_t nbits) {
@@ -124,7 +186,7 @@ public:
     inline bool empty() const { return _size==0u; }
 
     //! number of storage words
-    inline size_t wsize() const { return _words.size(); }
+    inline size_t wsize() const { return _wsize; }
     //! storage word
     inline uint64_t& word(size_t i) { return _words[i]; }
     inline const uint64_t& word(size_t i) const { return _words[i]; }
@@ -134,8 +196,24 @@ public:
 
     //! Returns index of first set bit in range [start, size()] inclusive.
     //! Returns size() if no bits are set.
-    PVXS_API
-    size_t findSet(size_t start=0u) const;
+    inline size_t findSet(size_t start=0u) const {
+        while(start < _size) {
+            size_t word = start/64u;
+            uint64_t masked = _words[word] & (~uint64_t(0u) << (start%64u)); // bit and higher
+            if(masked)
+                return std::min(size_t(_size), (word*64u) | detail::ctz64(masked));
+            start = (word+1u)*64u; // skip to next word
+        }
+        return _size;
+    }
+
+    //! Number of set bits
+    size_t count() const {
+        size_t ret = 0u;
+        for(size_t i=0; i<_wsize; i++)
+            ret += detail::popcount64(_words[i]);
+        return ret;
+    }
 
 private:
     template<typename BR>
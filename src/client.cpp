@@ -268,6 +268,19 @@ void Context::hurryUp()
     });
 }
 
+Context::PoolStats Context::poolStats() const
+{
+    if(!pvt)
+        throw std::logic_error("NULL Context");
+
+    PoolStats ret;
+    if(auto& pool = pvt->valuePool) {
+        ret.hits = pool->hits.load(std::memory_order_relaxed);
+        ret.misses = pool->misses.load(std::memory_order_relaxed);
+    }
+    return ret;
+}
+
 void Context::cacheClear()
 {
     if(!pvt)
@@ -293,6 +306,7 @@ Value buildCAMethod()
 
 Context::Pvt::Pvt(const Config& conf)
     :effective(conf)
+    ,valuePool(conf.valuePoolLimit ? std::make_shared<impl::ValuePool>(conf.valuePoolLimit) : nullptr)
     ,caMethod(buildCAMethod())
     ,searchTx(AF_INET, SOCK_DGRAM, 0)
     ,tcp_loop("PVXCTCP", epicsThreadPriorityCAServerLow)
@@ -17,11 +17,12 @@ DEFINE_LOGGER(io, "pvxs.client.io");
 Connection::Connection(const std::shared_ptr<Context::Pvt>& context, const SockAddr& peerAddr)
     :ConnBase (true,
                bufferevent_socket_new(context->tcp_loop.base, -1, BEV_OPT_CLOSE_ON_FREE|BEV_OPT_DEFER_CALLBACKS),
-               peerAddr)
+               peerAddr,
+               context->effective.tcp_readahead)
     ,context(context)
     ,echoTimer(event_new(context->tcp_loop.base, -1, EV_TIMEOUT|EV_PERSIST, &tickEchoS, this))
 {
-    bufferevent_setcb(bev.get(), &bevReadS, nullptr, &bevEventS, this);
+    bufferevent_setcb(bev.get(), &bevReadS, &bevWriteS, &bevEventS, this);
 
     // shorter timeout until connect() ?
     timeval timo = {30, 0};
@@ -389,9 +390,7 @@ void Connection::tickEcho()
     if(!bev)
         return;
 
-    auto tx = bufferevent_get_output(bev.get());
-
-    to_evbuf(tx, Header{CMD_ECHO, 0u, 0u}, hostBE);
+    enqueueTxBody(CMD_ECHO);
 
     // maybe help reduce latency
     bufferevent_flush(bev.get(), EV_WRITE, BEV_FLUSH);
@@ -177,6 +177,9 @@ struct Context::Pvt
     // "const" after ctor
     Config effective;
 
+    // storage for monitor updates.  may be NULL
+    const std::shared_ptr<impl::ValuePool> valuePool;
+
     const Value caMethod;
 
     uint32_t nextCID=0x12345678;
@@ -365,7 +365,7 @@ void Connection::handle_MONITOR()
 
         } else if(!final || !M.empty()) {
 
-            data = info->prototype.cloneEmpty();
+            data = Value::Helper::cloneEmpty(info->prototype, context->valuePool);
             from_wire_valid(M, rxRegistry, data);
 
             BitMask overrun;
@@ -12,6 +12,7 @@
 #include <dbDefs.h>
 #include <osiSock.h>
 #include <epicsString.h>
+#include <epicsThread.h>
 
 #include <pvxs/log.h>
 #include "serverconn.h"
@@ -166,6 +167,62 @@ Config Config::from_env()
         }
     }
 
+    if(const char *env = pickenv(&name, {"EPICS_PVAS_WORKERS"})) {
+        try {
+            ret.workers = parseTo<uint64_t>(env);
+        }catch(std::exception& e) {
+            log_err_printf(serversetup, "%s invalid integer : %s", name, e.what());
+        }
+    }
+
+    if(const char *env = pickenv(&name, {"EPICS_PVAS_TCP_LISTENERS"})) {
+        try {
+            ret.tcp_listeners = parseTo<uint64_t>(env);
+        }catch(std::exception& e) {
+            log_err_printf(serversetup, "%s invalid integer : %s", name, e.what());
+        }
+    }
+
+    if(const char *env = pickenv(&name, {"EPICS_PVAS_LISTEN_BACKLOG"})) {
+        try {
+            ret.listen_backlog = parseTo<uint64_t>(env);
+        }catch(std::exception& e) {
+            log_err_printf(serversetup, "%s invalid integer : %s", name, e.what());
+        }
+    }
+
+    if(const char *env = pickenv(&name, {"EPICS_PVAS_TCP_TX_HIGH"})) {
+        try {
+            ret.tcp_tx_high = parseTo<uint64_t>(env);
+        }catch(std::exception& e) {
+            log_err_printf(serversetup, "%s invalid integer : %s", name, e.what());
+        }
+    }
+
+    if(const char *env = pickenv(&name, {"EPICS_PVAS_TCP_TX_LOW"})) {
+        try {
+            ret.tcp_tx_low = parseTo<uint64_t>(env);
+        }catch(std::exception& e) {
+            log_err_printf(serversetup, "%s invalid integer : %s", name, e.what());
+        }
+    }
+
+    if(const char *env = pickenv(&name, {"EPICS_PVAS_TCP_TX_DRAIN"})) {
+        try {
+            ret.tcp_tx_drain = parseTo<uint64_t>(env);
+        }catch(std::exception& e) {
+            log_err_printf(serversetup, "%s invalid integer : %s", name, e.what());
+        }
+    }
+
+    if(const char *env = pickenv(&name, {"EPICS_PVAS_TCP_READAHEAD"})) {
+        try {
+            ret.tcp_readahead = parseTo<uint64_t>(env);
+        }catch(std::exception& e) {
+            log_err_printf(serversetup, "%s invalid integer : %s", name, e.what());
+        }
+    }
+
     return ret;
 }
 
@@ -195,6 +252,28 @@ void Config::expand()
         auto_beacon = false;
     }
 
+    if(workers==0u)
+        workers = epicsThreadGetCPUs();
+
+#ifndef SO_REUSEPORT
+    if(tcp_listeners>1u) {
+        log_warn_printf(serversetup, "SO_REUSEPORT not supported.  Using one TCP listener%s\n", "");
+        tcp_listeners = 1u;
+    }
+#endif
+    if(tcp_listeners==0u)
+        tcp_listeners = 1u;
+    if(workers<tcp_listeners)
+        workers = tcp_listeners;
+
+    if(tcp_tx_high==0u)
+        tcp_tx_high = 1u;
+    if(tcp_tx_low>tcp_tx_high)
+        tcp_tx_low = tcp_tx_high;
+    // less than one header would never be processed
+    if(tcp_readahead<8u)
+        tcp_readahead = 8u;
+
     removeDups(interfaces);
     removeDups(beaconDestinations);
 }
@@ -231,6 +310,20 @@ std::ostream& operator<<(std::ostream& strm, const Config& conf)
 
     strm<<"EPICS_PVAS_BROADCAST_PORT="<<conf.udp_port<<'\n';
 
+    strm<<"EPICS_PVAS_WORKERS="<<conf.workers<<'\n';
+
+    strm<<"EPICS_PVAS_TCP_LISTENERS="<<conf.tcp_listeners<<'\n';
+
+    strm<<"EPICS_PVAS_LISTEN_BACKLOG="<<conf.listen_backlog<<'\n';
+
+    strm<<"EPICS_PVAS_TCP_TX_HIGH="<<conf.tcp_tx_high<<'\n';
+
+    strm<<"EPICS_PVAS_TCP_TX_LOW="<<conf.tcp_tx_low<<'\n';
+
+    strm<<"EPICS_PVAS_TCP_TX_DRAIN="<<conf.tcp_tx_drain<<'\n';
+
+    strm<<"EPICS_PVAS_TCP_READAHEAD="<<conf.tcp_readahead<<'\n';
+
     return strm;
 }
 
@@ -270,6 +363,22 @@ Config Config::from_env()
         }
     }
 
+    if(const char *env = pickenv(&name, {"EPICS_PVA_VALUE_POOL"})) {
+        try {
+            ret.valuePoolLimit = parseTo<uint64_t>(env);
+        }catch(std::exception& e) {
+            log_err_printf(serversetup, "%s invalid integer : %s", name, e.what());
+        }
+    }
+
+    if(const char *env = pickenv(&name, {"EPICS_PVA_TCP_READAHEAD"})) {
+        try {
+            ret.tcp_readahead = parseTo<uint64_t>(env);
+        }catch(std::exception& e) {
+            log_err_printf(serversetup, "%s invalid integer : %s", name, e.what());
+        }
+    }
+
     return ret;
 }
 
@@ -278,6 +387,9 @@ void Config::expand()
     if(udp_port==0)
         throw std::runtime_error("Client can't use UDP random port");
 
+    if(tcp_readahead<8u)
+        tcp_readahead = 8u;
+
     if(interfaces.empty())
         interfaces.emplace_back("0.0.0.0");
 
@@ -308,6 +420,10 @@ std::ostream& operator<<(std::ostream& strm, const Config& conf)
 
     strm<<"EPICS_PVA_BROADCAST_PORT="<<conf.udp_port<<'\n';
 
+    strm<<"EPICS_PVA_VALUE_POOL="<<conf.valuePoolLimit<<'\n';
+
+    strm<<"EPICS_PVA_TCP_READAHEAD="<<conf.tcp_readahead<<'\n';
+
     return strm;
 }
 
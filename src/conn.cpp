@@ -15,22 +15,32 @@ DEFINE_LOGGER(connio, "pvxs.tcp.io");
 namespace pvxs {
 namespace impl {
 
-ConnBase::ConnBase(bool isClient, bufferevent* bev, const SockAddr& peerAddr)
+ConnBase::ConnBase(bool isClient, bufferevent* bev, const SockAddr& peerAddr, size_t readahead)
     :peerAddr(peerAddr)
     ,peerName(peerAddr.tostring())
     ,bev(bev)
+    ,txRegistryQueued(0u)
     ,isClient(isClient)
+    ,readahead(readahead)
     ,peerBE(true) // arbitrary choice, default should be overwritten before use
     ,expectSeg(false)
     ,segCmd(0xff)
+    ,rxHigh(readahead)
     ,segBuf(evbuffer_new())
     ,txBody(evbuffer_new())
+    ,txQueued(0u)
+    ,txSegmenting(false)
 {
     // initially wait for at least a header
-    bufferevent_setwatermark(this->bev.get(), EV_READ, 8, tcp_readahead);
+    bufferevent_setwatermark(this->bev.get(), EV_READ, 8, readahead);
 }
 
-ConnBase::~ConnBase() {}
+ConnBase::~ConnBase()
+{
+    log_debug_printf(connio, "%s %s limits reached: readahead %zu, tx high %zu, tx drain %zu\n",
+                     peerLabel(), peerName.c_str(),
+                     limitsHit.rxReadahead, limitsHit.txHigh, limitsHit.txDrain);
+}
 
 const char* ConnBase::peerLabel() const
 {
@@ -39,13 +49,146 @@ const char* ConnBase::peerLabel() const
 
 void ConnBase::enqueueTxBody(pva_app_msg_t cmd)
 {
-    auto tx = bufferevent_get_output(bev.get());
-    to_evbuf(tx, Header{cmd,
-                        uint8_t(isClient ? 0u : pva_flags::Server),
-                        uint32_t(evbuffer_get_length(txBody.get()))},
-             hostBE);
-    auto err = evbuffer_add_buffer(tx, txBody.get());
+    auto len = evbuffer_get_length(txBody.get());
+
+    // Type cache keys are assigned as messages are encoded.
+    // Did encoding this one assign any?
+    const bool definesType = txRegistry.size()!=txRegistryQueued;
+    txRegistryQueued = txRegistry.size();
+
+    if(txQueue.empty() && len <= tcp_tx_segment) {
+        // nothing waiting.  send immediately
+        auto tx = bufferevent_get_output(bev.get());
+        to_evbuf(tx, Header{cmd,
+                            uint8_t(isClient ? 0u : pva_flags::Server),
+                            uint32_t(len)},
+                 hostBE);
+        auto err = evbuffer_add_buffer(tx, txBody.get());
+        assert(!err);
+        return;
+    }
+
+    TxMsg msg{evbuf(evbuffer_new()), 0u, cmd, false, definesType};
+
+    if(!isClient) {
+        switch(cmd) {
+        case CMD_GET:
+        case CMD_PUT:
+        case CMD_PUT_GET:
+        case CMD_MONITOR:
+        case CMD_RPC:
+        case CMD_GET_FIELD:
+        case CMD_MESSAGE:
+            // replies to operations begin with the ioid
+            uint8_t raw[4];
+            if(evbuffer_copyout(txBody.get(), raw, sizeof(raw))==sizeof(raw)) {
+                FixedBuf K(hostBE, raw, sizeof(raw));
+                from_wire(K, msg.ioid);
+                msg.keyed = K.good();
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    auto err = evbuffer_add_buffer(msg.body.get(), txBody.get());
     assert(!err);
+
+    txQueued += len;
+    txQueue.push_back(std::move(msg));
+
+    pumpTx();
+}
+
+size_t ConnBase::txPending()
+{
+    size_t ret = txQueued;
+    if(bev)
+        ret += evbuffer_get_length(bufferevent_get_output(bev.get()));
+    return ret;
+}
+
+// May a short message be sent ahead of a long message queued before it?
+// Order is preserved between messages of the same operation,
+// and for messages not associated with an operation.
+// Nor may a message pass one defining type cache keys (0xFD) which it may use (0xFE).
+static
+bool mayPass(const ConnBase::TxMsg& small, const ConnBase::TxMsg& big)
+{
+    return small.cmd==CMD_ECHO || (small.keyed && big.keyed && !big.definesType && small.ioid!=big.ioid);
+}
+
+/* Move messages from txQueue to the output buffer, one segment at a time.
+ * Keeps roughly one segment in the output buffer, so that a short message
+ * queued while a long one is in progress is sent as soon as the long message
+ * completes, ahead of any other long messages which are waiting.
+ *
+ * Segments of one message are always sent consecutively as PVA does not permit
+ * other application messages to be interleaved with a segmented message.
+ */
+void ConnBase::pumpTx()
+{
+    if(!bev)
+        return;
+
+    auto tx = bufferevent_get_output(bev.get());
+    const uint8_t dir = isClient ? 0u : pva_flags::Server;
+
+    while(!txQueue.empty() && evbuffer_get_length(tx) < tcp_tx_segment) {
+
+        if(!txSegmenting) {
+            // at a message boundary.  Send the first short message
+            // which may pass all long messages queued before it.
+            auto it = txQueue.begin();
+            for(auto cur = txQueue.begin(), end = txQueue.end(); cur!=end; ++cur) {
+                if(evbuffer_get_length(cur->body.get()) > tcp_tx_segment)
+                    continue;
+
+                bool ok = true;
+                for(auto prev = txQueue.begin(); ok && prev!=cur; ++prev)
+                    ok = mayPass(*cur, *prev);
+                if(ok)
+                    it = cur;
+                break;
+            }
+
+            auto len = evbuffer_get_length(it->body.get());
+            if(len <= tcp_tx_segment) {
+                to_evbuf(tx, Header{it->cmd, dir, uint32_t(len)}, hostBE);
+                auto err = evbuffer_add_buffer(tx, it->body.get());
+                assert(!err);
+
+                txQueued -= len;
+                txQueue.erase(it);
+                continue;
+            }
+            assert(it==txQueue.begin());
+        }
+
+        // next segment of a long message
+        auto& msg = txQueue.front();
+        auto remaining = evbuffer_get_length(msg.body.get());
+        auto len = remaining < tcp_tx_segment ? remaining : tcp_tx_segment;
+        bool last = len==remaining;
+
+        uint8_t seg = txSegmenting ? pva_flags::SegMask : pva_flags::SegFirst;
+        if(last)
+            seg = pva_flags::SegLast;
+
+        to_evbuf(tx, Header{msg.cmd, uint8_t(dir|seg), uint32_t(len)}, hostBE);
+        auto n = evbuffer_remove_buffer(msg.body.get(), tx, len);
+        assert(n==int(len));
+
+        txQueued -= len;
+
+        if(last) {
+            txSegmenting = false;
+            txQueue.pop_front();
+        } else {
+            txSegmenting = true;
+        }
+    }
 }
 
 #define CASE(Op) void ConnBase::handle_##Op() {}
@@ -91,13 +234,28 @@ void ConnBase::bevEvent(short events)
         cleanup();
 }
 
+void ConnBase::setReadWatermark(size_t low, size_t high)
+{
+    rxHigh = high;
+    bufferevent_setwatermark(bev.get(), EV_READ, low, high);
+}
+
 void ConnBase::bevRead()
 {
     auto rx = bufferevent_get_input(bev.get());
     unsigned niter;
-
-
-    for(niter=0; niter<4 && bev && evbuffer_get_length(rx)>=8; niter++) {
+#if LIBEVENT_VERSION_NUMBER >= 0x02010000
+    // process a few messages, then yield.  cf. bufferevent_trigger() below
+    const unsigned maxiter = 4u;
+#else
+    // no way to revisit messages already received, so process them all now
+    const unsigned maxiter = std::numeric_limits<unsigned>::max();
+#endif
+
+    if(evbuffer_get_length(rx)>=rxHigh)
+        limitsHit.rxReadahead++;
+
+    for(niter=0; niter<maxiter && bev && evbuffer_get_length(rx)>=8; niter++) {
         uint8_t header[8];
 
         auto ret = evbuffer_copyout(rx, header, sizeof(header));
@@ -116,7 +274,7 @@ void ConnBase::bevRead()
         if(header[2]&pva_flags::Control) {
             // Control messages are not actually useful
             evbuffer_drain(rx, 8);
-            bufferevent_setwatermark(bev.get(), EV_READ, 8, tcp_readahead);
+            setReadWatermark(8, readahead);
             continue;
         }
         // application message
@@ -132,10 +290,10 @@ void ConnBase::bevRead()
         if(evbuffer_get_length(rx)-8 < len) {
             // wait for complete payload
             // and some additional if available
-            size_t readahead = len;
-            if(readahead < std::numeric_limits<size_t>::max()-tcp_readahead)
-                readahead += tcp_readahead;
-            bufferevent_setwatermark(bev.get(), EV_READ, len, readahead);
+            size_t high = len;
+            if(high < std::numeric_limits<size_t>::max()-readahead)
+                high += readahead;
+            setReadWatermark(len, high);
             break;
         }
 
@@ -207,15 +365,26 @@ void ConnBase::bevRead()
         }
 
         // wait for next header
-        bufferevent_setwatermark(bev.get(), EV_READ, 8, tcp_readahead);
+        setReadWatermark(8, readahead);
+    }
+
+#if LIBEVENT_VERSION_NUMBER >= 0x02010000
+    if(bev && niter==maxiter && evbuffer_get_length(rx)>=8) {
+        // More messages have already been received, and libevent will not call us
+        // again until more arrive.  Come back after others on this loop have had a turn.
+        bufferevent_trigger(bev.get(), EV_READ, BEV_TRIG_IGNORE_WATERMARKS|BEV_TRIG_DEFER_CALLBACKS);
     }
+#endif
 
     if(!bev) {
         cleanup();
     }
 }
 
-void ConnBase::bevWrite() {}
+void ConnBase::bevWrite()
+{
+    pumpTx();
+}
 
 void ConnBase::bevEventS(struct bufferevent *bev, short events, void *ptr)
 {
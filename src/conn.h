@@ -6,6 +6,8 @@
 #ifndef CONN_H
 #define CONN_H
 
+#include <deque>
+
 #include "evhelper.h"
 #include "dataimpl.h"
 #include "utilpvt.h"
@@ -13,10 +15,8 @@
 namespace pvxs {
 namespace impl {
 
-// Amount of following messages which we allow to be read while
-// processing the current message.  Avoids some extra recv() calls,
-// at the price of maybe extra copying.
-constexpr size_t tcp_readahead = 0x1000u;
+// Message bodies longer than this are sent as a sequence of segments.
+constexpr size_t tcp_tx_segment = 0x10000u;
 
 struct ConnBase
 {
@@ -24,15 +24,50 @@ struct ConnBase
     std::string peerName;
     evbufferevent bev;
     TypeStore rxRegistry;
+    TxTypeStore txRegistry;
+    // txRegistry.size() when the last message was queued.  cf. enqueueTxBody()
+    size_t txRegistryQueued;
 
     const bool isClient;
+    // Amount of following messages which we allow to be read while
+    // processing the current message.  Avoids some extra recv() calls,
+    // at the price of maybe extra copying.  cf. Config::tcp_readahead
+    const size_t readahead;
     bool peerBE;
     bool expectSeg;
 
     uint8_t segCmd;
+    // current high read watermark.  cf. limitsHit.rxReadahead
+    size_t rxHigh;
     evbuf segBuf, txBody;
 
-    ConnBase(bool isClient, bufferevent* bev, const SockAddr& peerAddr);
+    // Messages waiting to be sent.  Only used while a long (segmented)
+    // message is waiting or being sent.
+    struct TxMsg {
+        evbuf body;
+        uint32_t ioid; // valid if keyed
+        pva_app_msg_t cmd;
+        bool keyed;
+        // defines type cache keys, which later messages may refer to
+        bool definesType;
+    };
+    std::deque<TxMsg> txQueue;
+    // total body bytes in txQueue
+    size_t txQueued;
+    // some segments of txQueue.front() have been sent
+    bool txSegmenting;
+
+    // How often flow control limits were reached.  Logged when the connection closes.
+    struct Limits {
+        // reads stopped at readahead
+        size_t rxReadahead = 0u;
+        // (server) reading suspended at tcp_tx_high
+        size_t txHigh = 0u;
+        // (server) ready monitor sending stopped at tcp_tx_drain
+        size_t txDrain = 0u;
+    } limitsHit;
+
+    ConnBase(bool isClient, bufferevent* bev, const SockAddr& peerAddr, size_t readahead);
     ConnBase(const ConnBase&) = delete;
     ConnBase& operator=(const ConnBase&) = delete;
     virtual ~ConnBase();
@@ -41,6 +76,9 @@ struct ConnBase
 
     void enqueueTxBody(pva_app_msg_t cmd);
 
+    // bytes in the output buffer and waiting in txQueue
+    size_t txPending();
+
 protected:
 #define CASE(Op) virtual void handle_##Op();
     CASE(ECHO);
@@ -69,6 +107,9 @@ protected:
     virtual void bevEvent(short events);
     virtual void bevRead();
     virtual void bevWrite();
+    // move from txQueue to the output buffer
+    void pumpTx();
+    void setReadWatermark(size_t low, size_t high);
     static void bevEventS(struct bufferevent *bev, short events, void *ptr);
     static void bevReadS(struct bufferevent *bev, void *ptr);
     static void bevWriteS(struct bufferevent *bev, void *ptr);
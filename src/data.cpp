@@ -6,12 +6,15 @@
 
 #include <cstring>
 #include <epicsAssert.h>
+#include <epicsGuard.h>
 
 #include "dataimpl.h"
 #include "utilpvt.h"
 
 namespace pvxs {
 
+typedef epicsGuard<epicsMutex> Guard;
+
 NoField::NoField()
     :std::runtime_error ("No such field")
 {}
@@ -88,16 +91,78 @@ Value Value::Helper::build(const void* ptr, StoreType type)
     return ret;
 }
 
-Value::Value(const std::shared_ptr<const impl::FieldDesc>& desc)
-    :desc(nullptr)
+namespace {
+/* Allocator for std::allocate_shared() which places an array of FieldStorage
+ * after the shared_ptr control block (which contains the StructTop).
+ * So a StructTop, with all of its members, is one allocation.
+ */
+template<typename T>
+struct StructTopAlloc {
+    typedef T value_type;
+
+    size_t nfields;
+    // where allocate() places the FieldStorage array
+    FieldStorage** fields;
+    // where allocate() places the valid bits (zeroed) which follow the FieldStorage array
+    uint64_t** valid;
+    // optional.  Source of, and destination for, blocks.
+    std::shared_ptr<ValuePool> pool;
+
+    StructTopAlloc(size_t nfields, FieldStorage** fields, uint64_t** valid, const std::shared_ptr<ValuePool>& pool)
+        :nfields(nfields), fields(fields), valid(valid), pool(pool)
+    {}
+    template<typename U>
+    StructTopAlloc(const StructTopAlloc<U>& o) :nfields(o.nfields), fields(o.fields), valid(o.valid), pool(o.pool) {}
+
+    static_assert(alignof(FieldStorage)%alignof(uint64_t)==0, "valid bits follow FieldStorage");
+
+    static constexpr size_t offset() {
+        return (sizeof(T) + alignof(FieldStorage) - 1u)/alignof(FieldStorage)*alignof(FieldStorage);
+    }
+    size_t nwords() const {
+        return (nfields+63u)/64u;
+    }
+    size_t nbytes() const {
+        return offset() + nfields*sizeof(FieldStorage) + nwords()*sizeof(uint64_t);
+    }
+
+    T* allocate(size_t n) {
+        assert(n==1u);
+        auto raw = static_cast<char*>(pool ? pool->allocate(nbytes()) : ::operator new(nbytes()));
+        *fields = reinterpret_cast<FieldStorage*>(raw + offset());
+        *valid = reinterpret_cast<uint64_t*>(raw + offset() + nfields*sizeof(FieldStorage));
+        std::fill(*valid, *valid + nwords(), 0u);
+        return reinterpret_cast<T*>(raw);
+    }
+    void deallocate(T* p, size_t n) {
+        if(pool)
+            pool->release(p, nbytes());
+        else
+            ::operator delete(p);
+    }
+
+    template<typename U>
+    bool operator==(const StructTopAlloc<U>& o) const { return pool==o.pool; }
+    template<typename U>
+    bool operator!=(const StructTopAlloc<U>& o) const { return pool!=o.pool; }
+};
+
+std::shared_ptr<FieldStorage> buildTop(const std::shared_ptr<const impl::FieldDesc>& desc,
+                                       const std::shared_ptr<ValuePool>& pool)
 {
-    if(!desc)
-        return;
+    const size_t nfields = desc->size();
+    FieldStorage* fields = nullptr;
+    uint64_t* valid = nullptr;
 
-    auto top = std::make_shared<StructTop>();
+    auto top = std::allocate_shared<StructTop>(StructTopAlloc<StructTop>(nfields, &fields, &valid, pool));
+
+    for(auto i : range(nfields))
+        new (&fields[i]) FieldStorage();
+    top->members = fields;
+    top->nmembers = nfields;
+    top->valid = valid;
 
     top->desc = desc;
-    top->members.resize(desc->size());
     {
         auto& root = top->members[0];
         root.init(desc->code.storedAs());
@@ -107,15 +172,78 @@ Value::Value(const std::shared_ptr<const impl::FieldDesc>& desc)
     if(desc->code==TypeCode::Struct) {
         for(auto& pair : desc->mlookup) {
             auto cfld = desc.get() + pair.second;
-            auto& mem = top->members.at(pair.second);
+            auto& mem = top->members[pair.second];
             mem.top = top.get();
             mem.init(cfld->code.storedAs());
         }
     }
 
+    return std::shared_ptr<FieldStorage>(top, top->members); // alias
+}
+} // namespace
+
+Value::Value(const std::shared_ptr<const impl::FieldDesc>& desc)
+    :desc(nullptr)
+{
+    if(!desc)
+        return;
+
+    this->store = buildTop(desc, nullptr);
     this->desc = desc.get();
-    decltype (store) val(top, top->members.data()); // alias
-    this->store = std::move(val);
+}
+
+Value Value::Helper::cloneEmpty(const Value& proto, const std::shared_ptr<impl::ValuePool>& pool)
+{
+    Value ret;
+    if(proto.desc) {
+        decltype (proto.store->top->desc) fld(proto.store->top->desc, proto.desc);
+        ret.store = buildTop(fld, pool);
+        ret.desc = proto.desc;
+    }
+    return ret;
+}
+
+ValuePool::ValuePool(size_t limit)
+    :limit(limit)
+{}
+
+ValuePool::~ValuePool()
+{
+    for(auto& pair : unused) {
+        for(auto block : pair.second)
+            ::operator delete(block);
+    }
+}
+
+void* ValuePool::allocate(size_t nbytes)
+{
+    {
+        Guard G(lock);
+        auto it = unused.find(nbytes);
+        if(it!=unused.end() && !it->second.empty()) {
+            auto ret = it->second.back();
+            it->second.pop_back();
+            hits.fetch_add(1u, std::memory_order_relaxed);
+            return ret;
+        }
+    }
+    misses.fetch_add(1u, std::memory_order_relaxed);
+    return ::operator new(nbytes);
+}
+
+void ValuePool::release(void* block, size_t nbytes)
+{
+    {
+        Guard G(lock);
+        auto& blocks = unused[nbytes];
+        if(blocks.size() < limit) {
+            if(blocks.capacity()==0u)
+                blocks.reserve(limit);
+            blocks.push_back(block);
+            return;
+        }
+    }
+    ::operator delete(block);
 }
 
 Value::Value(const std::shared_ptr<const impl::FieldDesc>& desc, Value& parent)
@@ -162,6 +290,89 @@ Value& Value::assign(const Value& o)
     return *this;
 }
 
+namespace {
+void freezeTop(StructTop* top);
+
+// Freeze a member Value (of an Any or Union, or an element of a Value[]).
+// When not frozen and also referenced elsewhere, eg. by the caller of SharedPV::post(),
+// freeze a private copy instead.
+void freezeMember(Value& mem)
+{
+    auto& mstore = Value::Helper::store(mem);
+    if(!mstore)
+        return;
+    if(!mstore->top->frozen && mstore.use_count()>1)
+        mem = mem.clone();
+    freezeTop(Value::Helper::store_ptr(mem)->top);
+}
+
+void freezeTop(StructTop* top)
+{
+    if(top->frozen)
+        return;
+    top->frozen = true;
+
+    for(auto i : range(top->nmembers)) {
+        auto& fld = top->members[i];
+        if(fld.code==StoreType::Compound) {
+            freezeMember(fld.as<Value>());
+
+        } else if(fld.code==StoreType::Array) {
+            auto& arr = fld.as<shared_array<const void>>();
+            if(arr.original_type()==ArrayType::Value) {
+                // elements of an array shared with others must all be copied
+                const bool shared = !arr.unique();
+                auto elems(arr.castTo<const Value>());
+                shared_array<Value> mine(elems.size());
+                for(auto j : range(elems.size())) {
+                    mine[j] = elems[j];
+                    if(shared && mine[j].valid() && !mine[j].isFrozen())
+                        mine[j] = mine[j].clone();
+                }
+                elems.clear();
+                arr.clear();
+                for(auto& elem : mine)
+                    freezeMember(elem);
+                arr = mine.freeze().castTo<const void>();
+            }
+        }
+    }
+}
+
+// propagate mark() to fields which enclose 'top'.  eg. Struct[] containing this Struct
+void markEnclosing(StructTop* top)
+{
+    std::shared_ptr<FieldStorage> enc;
+    while(top && (enc=top->enclosing.lock())) {
+        enc->valid(true);
+        top = enc->top;
+    }
+}
+
+void checkThawed(const FieldStorage* store)
+{
+    if(store->top->frozen)
+        throw std::logic_error("Can't modify frozen Value.  Recommend pvxs::Value::thaw()");
+}
+} // namespace
+
+Value& Value::freeze()
+{
+    if(store)
+        freezeTop(store->top);
+    return *this;
+}
+
+bool Value::isFrozen() const
+{
+    return store && store->top->frozen;
+}
+
+Value Value::thaw() const
+{
+    return isFrozen() ? clone() : *this;
+}
+
 Value Value::allocMember()
 {
     // allocate member type for Struct[] or Union[]
@@ -177,19 +388,15 @@ bool Value::isMarked(bool parents, bool children) const
     if(!desc)
         return false;
 
-    if(store->valid)
+    if(store->valid())
         return true;
 
     auto top = store->top;
 
     if(children && desc->size()>1u) {
-        // TODO more efficient
-        for(auto bit : range(desc->size()))
-        {
-            auto cstore = store.get() + bit;
-            if(cstore->valid)
-                return true;
-        }
+        auto idx = store->index();
+        if(top->anyValid(idx, idx + desc->size()))
+            return true;
     }
 
     if(parents) {
@@ -199,7 +406,7 @@ bool Value::isMarked(bool parents, bool children) const
             pstore -= pdesc->parent_index;
             pdesc -= pdesc->parent_index;
 
-            if(pstore->valid)
+            if(pstore->valid())
                 return true;
         }
     }
@@ -219,34 +426,26 @@ void Value::mark(bool v)
 {
     if(!desc)
         return;
+    checkThawed(store.get());
 
-    store->valid = v;
-    if(!v)
-        return;
-
-    auto top = store->top;
-    std::shared_ptr<FieldStorage> enc;
-    while(top && (enc=top->enclosing.lock())) {
-        enc->valid = true;
-        top = enc->top;
-    }
+    store->valid(v);
+    if(v)
+        markEnclosing(store->top);
 }
 
 void Value::unmark(bool parents, bool children)
 {
     if(!desc)
         return;
+    checkThawed(store.get());
 
-    store->valid = false;
+    store->valid(false);
 
     auto top = store->top;
 
     if(children && desc->size()>1u) {
-        // TODO more efficient
-        for(auto bit : range(desc->size()))
-        {
-            (store.get() + bit)->valid = false;
-        }
+        auto idx = store->index();
+        top->clearValid(idx, idx + desc->size());
     }
 
     if(parents) {
@@ -256,7 +455,7 @@ void Value::unmark(bool parents, bool children)
             pdesc -= pdesc->parent_index;
             pstore -= pdesc->parent_index;
 
-            pstore->valid = false;
+            pstore->valid(false);
         }
     }
 }
@@ -284,22 +483,33 @@ bool Value::idStartsWith(const std::string& prefix) const
     return ID.size()>=prefix.size() && prefix==ID.substr(0u, prefix.size());
 }
 
-const std::string &Value::nameOf(const Value& decendent) const
+const std::string& Value::nameOf(const Value& decendent) const
 {
     if(!store || !decendent.store)
         throw NoField();
     auto pidx = store->index();
     auto didx = decendent.store->index();
-    if(pidx >= didx || didx >= store->top->members.size())
+    if(pidx >= didx || didx >= store->top->nmembers)
         throw std::logic_error("not a decendent");
 
-    // inefficient, but we don't keep a reverse mapping
-    for(auto& it : desc->mlookup) {
-        if(it.second == didx-pidx)
-            return it.first;
+    auto names(std::atomic_load(&desc->mnames));
+    if(!names) {
+        auto temp(std::make_shared<std::vector<std::string>>(desc->size()));
+        for(auto& it : desc->mlookup) {
+            if(it.second < temp->size())
+                (*temp)[it.second] = it.first;
+        }
+        std::shared_ptr<const std::vector<std::string>> expect;
+        names = temp;
+        // first to finish wins.  Once set, never replaced, so references remain valid.
+        if(!std::atomic_compare_exchange_strong(&desc->mnames, &expect, names))
+            names = expect;
     }
 
-    throw std::logic_error("missing decendent");
+    auto rel = didx-pidx;
+    if(rel >= names->size() || (*names)[rel].empty())
+        throw std::logic_error("missing decendent");
+    return (*names)[rel];
 }
 
 namespace {
@@ -447,6 +657,7 @@ void Value::copyIn(const void *ptr, StoreType type)
 
     if(!desc)
         throw NoField();
+    checkThawed(store.get());
 
     switch(store->code) {
     case StoreType::Real:     if(!copyInScalar(store->as<double>(), ptr, type)) throw NoConvert(); break;
@@ -536,7 +747,50 @@ void Value::copyIn(const void *ptr, StoreType type)
     case StoreType::Null:
         if(type==StoreType::Compound) {
             auto& src = *reinterpret_cast<const Value*>(ptr);
-            if(src.type()==TypeCode::Struct) {
+            if(src.desc==desc) {
+                // same type.  copy only marked fields, by index without name lookups.
+                // eg. when squashing a monitor update.
+                bool any = false;
+                const auto stop = src.store->top;
+                const auto sbase = src.store->index();
+                const auto N = desc->size();
+                for(size_t idx = stop->findValid(sbase+1u, sbase+N)-sbase; idx < N;) {
+                    auto sfld = src.store.get() + idx;
+                    auto dfld = store.get() + idx;
+                    auto cdesc = desc + idx;
+
+                    switch(sfld->code) {
+                    case StoreType::Null: break; // sub-struct.  only mark
+                    case StoreType::Bool:     dfld->as<bool>() = sfld->as<bool>(); break;
+                    case StoreType::Real:     dfld->as<double>() = sfld->as<double>(); break;
+                    case StoreType::Integer:  dfld->as<int64_t>() = sfld->as<int64_t>(); break;
+                    case StoreType::UInteger: dfld->as<uint64_t>() = sfld->as<uint64_t>(); break;
+                    case StoreType::String:   dfld->as<std::string>() = sfld->as<std::string>(); break;
+                    case StoreType::Array:
+                        dfld->as<shared_array<const void>>() = sfld->as<shared_array<const void>>();
+                        break;
+                    case StoreType::Compound: {
+                        // Union or Any.  same rules as below
+                        Value dval;
+                        dval.store = decltype(store)(store, dfld);
+                        dval.desc = cdesc;
+                        dval.copyIn(&sfld->store, sfld->code);
+                        break;
+                    }
+                    }
+                    dfld->valid(true);
+                    any = true;
+                    // as imarked(), skip over members of a marked sub-struct
+                    idx = stop->findValid(sbase + idx + cdesc->size(), sbase+N)-sbase;
+                }
+                if(any)
+                    markEnclosing(store->top);
+                if(src.isMarked())
+                    mark();
+
+                return;
+
+            } else if(src.type()==TypeCode::Struct) {
                 // copy struct to struct
                 // all marked source field may be mapped to destination fields
 
@@ -580,6 +834,65 @@ bool Value::tryCopyIn(const void *ptr, StoreType type)
     }
 }
 
+void Value::copyOut(const FieldRef& ref, void *ptr, StoreType type) const
+{
+    if(desc && desc==ref.base.get()) {
+        // scalar and string fields w/o a temporary Value
+        auto fld = store.get() + ref.offset;
+        switch(fld->code) {
+        case StoreType::Real:     if(copyOutScalar(fld->as<double>(), ptr, type)) return; else break;
+        case StoreType::Integer:  if(copyOutScalar(fld->as<int64_t>(), ptr, type)) return; else break;
+        case StoreType::UInteger: if(copyOutScalar(fld->as<uint64_t>(), ptr, type)) return; else break;
+        case StoreType::Bool:
+            if(type==StoreType::Bool) {
+                *reinterpret_cast<bool*>(ptr) = fld->as<bool>();
+                return;
+            }
+            break;
+        case StoreType::String:
+            if(type==StoreType::String) {
+                *reinterpret_cast<std::string*>(ptr) = fld->as<std::string>();
+                return;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    (*this)[ref].copyOut(ptr, type);
+}
+
+void Value::copyIn(const FieldRef& ref, const void *ptr, StoreType type)
+{
+    if(desc && desc==ref.base.get()) {
+        // scalar and string fields w/o a temporary Value
+        auto fld = store.get() + ref.offset;
+        checkThawed(fld);
+        bool done = false;
+        switch(fld->code) {
+        case StoreType::Real:     done = copyInScalar(fld->as<double>(), ptr, type); break;
+        case StoreType::Integer:  done = copyInScalar(fld->as<int64_t>(), ptr, type); break;
+        case StoreType::UInteger: done = copyInScalar(fld->as<uint64_t>(), ptr, type); break;
+        case StoreType::Bool:
+            if((done = type==StoreType::Bool))
+                fld->as<bool>() = *reinterpret_cast<const bool*>(ptr);
+            break;
+        case StoreType::String:
+            if((done = type==StoreType::String))
+                fld->as<std::string>() = *reinterpret_cast<const std::string*>(ptr);
+            break;
+        default:
+            break;
+        }
+        if(done) {
+            fld->valid(true);
+            markEnclosing(fld->top);
+            return;
+        }
+    }
+    (*this)[ref].copyIn(ptr, type);
+}
+
 void Value::traverse(const std::string &expr, bool modify)
 {
     size_t pos=0;
@@ -620,11 +933,11 @@ void Value::traverse(const std::string &expr, bool modify)
                 pos++;
             }
 
-            size_t sep = expr.find_first_of("<[-", pos);
+            size_t sep = std::min(expr.find_first_of("<[-", pos), expr.size());
 
-            decltype (desc->mlookup)::const_iterator it;
+            auto it(desc->mlookup.end());
 
-            if(sep>0 && (it=desc->mlookup.find(expr.substr(pos, sep-pos)))!=desc->mlookup.end()) {
+            if(sep>0 && (it=desc->mlookup.find(expr.data()+pos, sep-pos))!=desc->mlookup.end()) {
                 // found it
                 auto next = desc+it->second;
                 decltype(store) value(store, store.get()+it->second);
@@ -653,17 +966,18 @@ void Value::traverse(const std::string &expr, bool modify)
 
                 } else {
                     // select member of Union
-                    size_t sep = expr.find_first_of("<[-.", pos);
+                    size_t sep = std::min(expr.find_first_of("<[-.", pos), expr.size());
 
-                    decltype (desc->mlookup)::const_iterator it;
+                    auto it(desc->mlookup.end());
 
-                    if(sep>0 && (it=desc->mlookup.find(expr.substr(pos, sep-pos)))!=desc->mlookup.end()) {
+                    if(sep>0 && (it=desc->mlookup.find(expr.data()+pos, sep-pos))!=desc->mlookup.end()) {
                         // found it.
                         auto& fld = store->as<Value>();
 
                         if(modify || fld.desc==&desc->members[it->second]) {
                             // will select, or already selected
                             if(fld.desc!=&desc->members[it->second]) {
+                                checkThawed(store.get());
                                 // select
                                 std::shared_ptr<const FieldDesc> mtype(store->top->desc, &desc->members[it->second]);
                                 fld = Value(mtype, *this);
@@ -740,6 +1054,49 @@ const Value Value::operator[](const char *name) const
     return ret;
 }
 
+Value Value::operator[](const FieldRef& ref)
+{
+    if(desc && desc==ref.base.get()) {
+        Value ret;
+        ret.store = decltype(store)(store, store.get()+ref.offset);
+        ret.desc = desc + ref.offset;
+        return ret;
+    } else if(!ref.base) {
+        return Value();
+    }
+    return (*this)[ref.expr];
+}
+
+const Value Value::operator[](const FieldRef& ref) const
+{
+    if(desc && desc==ref.base.get()) {
+        Value ret;
+        ret.store = decltype(store)(store, store.get()+ref.offset);
+        ret.desc = desc + ref.offset;
+        return ret;
+    } else if(!ref.base) {
+        return Value();
+    }
+    return (*this)[ref.expr];
+}
+
+FieldRef::FieldRef(const Value& proto, const std::string& name)
+    :offset(0u)
+    ,expr(name)
+{
+    auto fld(proto[name]);
+    if(!fld)
+        throw NoField();
+
+    auto pstore = Value::Helper::store_ptr(proto);
+    auto fstore = Value::Helper::store_ptr(fld);
+    if(fstore->top!=pstore->top || fstore<pstore)
+        throw std::logic_error(SB()<<"FieldRef \""<<name<<"\" must name a decendant of a Struct, not through Union, Any, or Struct[]");
+
+    base = Value::Helper::type(proto);
+    offset = fstore - pstore;
+}
+
 void Value::_iter_fl(Value::IterInfo &info, bool first) const
 {
     if(!store)
@@ -764,15 +1121,14 @@ void Value::_iter_advance(IterInfo& info) const
 {
     assert(info.depth);
 
-    // scan forward to find next non-marked
-    for(auto idx : range(info.pos, desc->size())) {
-        auto S = store.get() + idx;
-        if(S->valid) {
-            auto D = desc + idx;
-            info.pos = idx;
-            info.nextcheck = idx + D->size();
-            return;
-        }
+    // scan forward to find next marked
+    const auto base = store->index();
+    auto idx = store->top->findValid(base + info.pos, base + desc->size()) - base;
+    if(idx < desc->size()) {
+        auto D = desc + idx;
+        info.pos = idx;
+        info.nextcheck = idx + D->size();
+        return;
     }
 
     info.pos = info.nextcheck = desc->size();
@@ -850,10 +1206,51 @@ FieldStorage::~FieldStorage()
     deinit();
 }
 
-size_t FieldStorage::index() const
+StructTop::~StructTop()
 {
-    const size_t ret = this-top->members.data();
-    return ret;
+    // members were constructed in place.  cf. StructTopAlloc
+    for(auto i=nmembers; i; i--)
+        members[i-1u].~FieldStorage();
+}
+
+size_t StructTop::findValid(size_t first, size_t last) const
+{
+    while(first < last) {
+        auto word = valid[first/64u] & ~((uint64_t(1u)<<(first%64u))-1u); // bit and higher
+        if(word) {
+            auto bit = (first & ~size_t(0x3f)) | detail::ctz64(word);
+            return std::min(bit, last);
+        }
+        first = (first/64u + 1u)*64u;
+    }
+    return last;
+}
+
+void StructTop::clearValid(size_t first, size_t last)
+{
+    while(first < last) {
+        auto lo = first%64u;
+        auto n = std::min(size_t(64u) - lo, last - first);
+        auto bits = n==64u ? ~uint64_t(0u) : ((uint64_t(1u)<<n)-1u)<<lo;
+        valid[first/64u] &= ~bits;
+        first += n;
+    }
+}
+
+void StructTop::copyValid(BitMask& mask, size_t first) const
+{
+    const auto nw = vwords();
+    const auto shift = first%64u;
+    for(auto i : range(mask.wsize())) {
+        auto w = first/64u + i;
+        uint64_t val = w < nw ? valid[w] >> shift : 0u;
+        if(shift && w+1u < nw)
+            val |= valid[w+1u] << (64u - shift);
+        mask.word(i) = val;
+    }
+    // clear bits beyond mask.size()
+    if(auto extra = mask.size()%64u)
+        mask.word(mask.wsize()-1u) &= (uint64_t(1u)<<extra)-1u;
 }
 
 }} // namespace pvxs::impl
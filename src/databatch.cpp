@@ -0,0 +1,373 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvxs is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <cstring>
+
+#include "dataimpl.h"
+#include "utilpvt.h"
+
+namespace pvxs {
+
+struct ValueBatch::Pvt {
+    // prototype, cloneEmpty() of the Value given to ctor.  Top level.
+    Value proto;
+    // our type
+    const impl::FieldDesc* desc = nullptr;
+
+    struct Column {
+        std::string name;
+        // field index, relative to desc
+        size_t index = 0u;
+        // indices of enclosing sub-Structs, excluding desc itself
+        std::vector<size_t> parents;
+        StoreType code = StoreType::Null;
+
+        // only one of the following is used, depending on code
+        std::vector<double> reals;
+        std::vector<int64_t> ints;
+        std::vector<uint64_t> uints;
+        std::vector<uint8_t> bools;
+        // String: row i is chars[ends[i-1], ends[i])
+        std::string chars;
+        std::vector<size_t> ends;
+        std::vector<shared_array<const void>> arrays;
+        std::vector<Value> values;
+    };
+    std::vector<Column> columns;
+
+    // marked flags.  row i is words [i*vwords, (i+1)*vwords)
+    // with bit j for field j (relative to desc)
+    std::vector<uint64_t> marks;
+    size_t vwords = 0u;
+    size_t nrows = 0u;
+
+    const Column& column(size_t col) const {
+        if(col >= columns.size())
+            throw std::out_of_range(SB()<<"ValueBatch column "<<col<<" out of range");
+        return columns[col];
+    }
+
+    void checkRow(size_t row) const {
+        if(row >= nrows)
+            throw std::out_of_range(SB()<<"ValueBatch row "<<row<<" out of range");
+    }
+
+    inline bool bit(size_t row, size_t index) const {
+        return marks[row*vwords + index/64u] & (uint64_t(1u)<<(index%64u));
+    }
+};
+
+ValueBatch::ValueBatch(const Value& proto)
+{
+    auto desc = Value::Helper::desc(proto);
+    if(!desc || desc->code!=TypeCode::Struct)
+        throw std::logic_error("ValueBatch requires a Struct");
+
+    auto P(std::make_shared<Pvt>());
+    P->proto = proto.cloneEmpty();
+    P->desc = Value::Helper::desc(P->proto);
+    P->vwords = (desc->size()+63u)/64u;
+
+    // leaf field index -> name
+    std::vector<std::string> names(desc->size());
+    for(auto& it : desc->mlookup)
+        names[it.second] = it.first.str();
+
+    auto store = Value::Helper::store_ptr(P->proto);
+
+    for(auto i : range(size_t(1u), desc->size())) {
+        auto code = store[i].code;
+        if(code==StoreType::Null)
+            continue; // sub-Struct
+
+        Pvt::Column col;
+        col.name = std::move(names[i]);
+        col.index = i;
+        col.code = code;
+        for(auto p = i - desc[i].parent_index; p!=0u; p -= desc[p].parent_index)
+            col.parents.push_back(p);
+        P->columns.push_back(std::move(col));
+    }
+
+    pvt = std::move(P);
+}
+
+ValueBatch::~ValueBatch() {}
+
+size_t ValueBatch::size() const
+{
+    return pvt ? pvt->nrows : 0u;
+}
+
+size_t ValueBatch::ncolumns() const
+{
+    return pvt ? pvt->columns.size() : 0u;
+}
+
+size_t ValueBatch::find(const std::string& name) const
+{
+    if(pvt) {
+        for(auto i : range(pvt->columns.size())) {
+            if(pvt->columns[i].name==name)
+                return i;
+        }
+    }
+    throw NoField();
+}
+
+const std::string& ValueBatch::name(size_t col) const
+{
+    if(!pvt)
+        throw std::out_of_range("Empty ValueBatch");
+    return pvt->column(col).name;
+}
+
+StoreType ValueBatch::storageType(size_t col) const
+{
+    if(!pvt)
+        throw std::out_of_range("Empty ValueBatch");
+    return pvt->column(col).code;
+}
+
+void ValueBatch::reserve(size_t nrows)
+{
+    if(!pvt)
+        return;
+
+    pvt->marks.reserve(nrows*pvt->vwords);
+    for(auto& col : pvt->columns) {
+        switch(col.code) {
+        case StoreType::Real:     col.reals.reserve(nrows); break;
+        case StoreType::Integer:  col.ints.reserve(nrows); break;
+        case StoreType::UInteger: col.uints.reserve(nrows); break;
+        case StoreType::Bool:     col.bools.reserve(nrows); break;
+        case StoreType::String:   col.ends.reserve(nrows); break;
+        case StoreType::Array:    col.arrays.reserve(nrows); break;
+        case StoreType::Compound: col.values.reserve(nrows); break;
+        case StoreType::Null:     break;
+        }
+    }
+}
+
+void ValueBatch::append(const Value& val)
+{
+    if(!pvt || !val.compareType(pvt->proto))
+        throw std::logic_error("ValueBatch::append() requires the prototype type");
+
+    auto src = Value::Helper::store_ptr(val);
+    auto top = src->top;
+    auto base = src->index();
+
+    for(auto& col : pvt->columns) {
+        auto& fld = src[col.index];
+
+        switch(col.code) {
+        case StoreType::Real:     col.reals.push_back(fld.as<double>()); break;
+        case StoreType::Integer:  col.ints.push_back(fld.as<int64_t>()); break;
+        case StoreType::UInteger: col.uints.push_back(fld.as<uint64_t>()); break;
+        case StoreType::Bool:     col.bools.push_back(fld.as<bool>()); break;
+        case StoreType::String:
+            col.chars += fld.as<std::string>();
+            col.ends.push_back(col.chars.size());
+            break;
+        case StoreType::Array:    col.arrays.push_back(fld.as<shared_array<const void>>()); break;
+        case StoreType::Compound: {
+            // copy, as a Union or Any member may be changed in place later
+            auto& v = fld.as<Value>();
+            col.values.push_back(v ? v.clone() : Value());
+            break;
+        }
+        case StoreType::Null:     break;
+        }
+    }
+
+    auto nfields = pvt->desc->size();
+    pvt->marks.resize(pvt->marks.size() + pvt->vwords, 0u);
+    auto row = &pvt->marks[pvt->nrows*pvt->vwords];
+    if(base==0u) {
+        std::copy(top->valid, top->valid + pvt->vwords, row);
+
+    } else {
+        for(auto i = top->findValid(base, base+nfields); i < base+nfields; i = top->findValid(i+1u, base+nfields)) {
+            auto j = i - base;
+            row[j/64u] |= uint64_t(1u)<<(j%64u);
+        }
+    }
+
+    pvt->nrows++;
+}
+
+void ValueBatch::clear()
+{
+    if(!pvt)
+        return;
+
+    for(auto& col : pvt->columns) {
+        col.reals.clear();
+        col.ints.clear();
+        col.uints.clear();
+        col.bools.clear();
+        col.chars.clear();
+        col.ends.clear();
+        col.arrays.clear();
+        col.values.clear();
+    }
+    pvt->marks.clear();
+    pvt->nrows = 0u;
+}
+
+namespace {
+template<typename E, typename V>
+shared_array<const void> toArray(const V& vec)
+{
+    shared_array<E> ret(vec.size());
+    std::copy(vec.begin(), vec.end(), ret.begin());
+    return ret.freeze().template castTo<const void>();
+}
+}
+
+shared_array<const void> ValueBatch::column(size_t idx) const
+{
+    if(!pvt)
+        throw std::out_of_range("Empty ValueBatch");
+    auto& col = pvt->column(idx);
+
+    switch(col.code) {
+    case StoreType::Real:     return toArray<double>(col.reals);
+    case StoreType::Integer:  return toArray<int64_t>(col.ints);
+    case StoreType::UInteger: return toArray<uint64_t>(col.uints);
+    case StoreType::Bool:     return toArray<bool>(col.bools);
+    case StoreType::String: {
+        shared_array<std::string> ret(pvt->nrows);
+        size_t start = 0u;
+        for(auto i : range(pvt->nrows)) {
+            ret[i] = col.chars.substr(start, col.ends[i]-start);
+            start = col.ends[i];
+        }
+        return ret.freeze().castTo<const void>();
+    }
+    case StoreType::Compound: {
+        // copies, so that stored rows can't be changed
+        shared_array<Value> ret(col.values.size());
+        for(auto i : range(col.values.size()))
+            ret[i] = col.values[i].clone();
+        return ret.freeze().castTo<const void>();
+    }
+    case StoreType::Array:
+    case StoreType::Null:
+        break;
+    }
+    throw std::logic_error(SB()<<"ValueBatch column \""<<col.name<<"\" can not be extracted as an array");
+}
+
+bool ValueBatch::isMarked(size_t row, size_t idx) const
+{
+    if(!pvt)
+        throw std::out_of_range("Empty ValueBatch");
+    auto& col = pvt->column(idx);
+    pvt->checkRow(row);
+
+    if(pvt->bit(row, col.index) || pvt->bit(row, 0u))
+        return true;
+    for(auto p : col.parents) {
+        if(pvt->bit(row, p))
+            return true;
+    }
+    return false;
+}
+
+Value ValueBatch::value(size_t row) const
+{
+    if(!pvt)
+        throw std::out_of_range("Empty ValueBatch");
+    pvt->checkRow(row);
+
+    auto ret(pvt->proto.cloneEmpty());
+    auto dst = Value::Helper::store_ptr(ret);
+
+    for(auto& col : pvt->columns) {
+        auto& fld = dst[col.index];
+
+        switch(col.code) {
+        case StoreType::Real:     fld.as<double>() = col.reals[row]; break;
+        case StoreType::Integer:  fld.as<int64_t>() = col.ints[row]; break;
+        case StoreType::UInteger: fld.as<uint64_t>() = col.uints[row]; break;
+        case StoreType::Bool:     fld.as<bool>() = col.bools[row]; break;
+        case StoreType::String: {
+            size_t start = row ? col.ends[row-1u] : 0u;
+            fld.as<std::string>().assign(col.chars, start, col.ends[row]-start);
+            break;
+        }
+        case StoreType::Array:    fld.as<shared_array<const void>>() = col.arrays[row]; break;
+        case StoreType::Compound: {
+            auto& v = col.values[row];
+            if(v)
+                fld.as<Value>() = v.clone();
+            break;
+        }
+        case StoreType::Null:     break;
+        }
+    }
+
+    auto& marks = pvt->marks;
+    std::copy(marks.begin() + row*pvt->vwords,
+              marks.begin() + (row+1u)*pvt->vwords,
+              dst->top->valid);
+
+    return ret;
+}
+
+void ValueBatch::copyOut(size_t row, size_t idx, void *ptr, StoreType type) const
+{
+    if(!pvt)
+        throw std::out_of_range("Empty ValueBatch");
+    auto& col = pvt->column(idx);
+    pvt->checkRow(row);
+
+    // fast path when no conversion needed
+    if(type==col.code) {
+        switch(col.code) {
+        case StoreType::Real:     *reinterpret_cast<double*>(ptr) = col.reals[row]; return;
+        case StoreType::Integer:  *reinterpret_cast<int64_t*>(ptr) = col.ints[row]; return;
+        case StoreType::UInteger: *reinterpret_cast<uint64_t*>(ptr) = col.uints[row]; return;
+        case StoreType::Bool:     *reinterpret_cast<bool*>(ptr) = col.bools[row]; return;
+        case StoreType::String: {
+            size_t start = row ? col.ends[row-1u] : 0u;
+            reinterpret_cast<std::string*>(ptr)->assign(col.chars, start, col.ends[row]-start);
+            return;
+        }
+        case StoreType::Array:    *reinterpret_cast<shared_array<const void>*>(ptr) = col.arrays[row]; return;
+        // a copy, as for append() and value(), so that stored rows can't be changed
+        case StoreType::Compound: *reinterpret_cast<Value*>(ptr) = col.values[row].clone(); return;
+        case StoreType::Null:     break;
+        }
+        throw NoConvert();
+    }
+
+    // otherwise, convert as Value::copyOut() would
+    switch(col.code) {
+    case StoreType::Real:     Value::Helper::build(&col.reals[row], col.code).copyOut(ptr, type); return;
+    case StoreType::Integer:  Value::Helper::build(&col.ints[row], col.code).copyOut(ptr, type); return;
+    case StoreType::UInteger: Value::Helper::build(&col.uints[row], col.code).copyOut(ptr, type); return;
+    case StoreType::Bool: {
+        bool b = col.bools[row];
+        Value::Helper::build(&b, col.code).copyOut(ptr, type);
+        return;
+    }
+    case StoreType::String: {
+        std::string s;
+        copyOut(row, idx, &s, StoreType::String);
+        Value::Helper::build(&s, col.code).copyOut(ptr, type);
+        return;
+    }
+    case StoreType::Array:    Value::Helper::build(&col.arrays[row], col.code).copyOut(ptr, type); return;
+    case StoreType::Compound: Value::Helper::build(&col.values[row], col.code).copyOut(ptr, type); return;
+    case StoreType::Null:     break;
+    }
+    throw NoConvert();
+}
+
+} // namespace pvxs
@@ -66,6 +66,64 @@ void to_wire(Buffer& buf, const FieldDesc* cur)
     }
 }
 
+void to_wire(Buffer& buf, const std::shared_ptr<const FieldDesc>& cur, TxTypeStore& cache)
+{
+    if(!cur) {
+        to_wire(buf, uint8_t(0xff));
+        return;
+    }
+
+    {
+        auto it = cache.byDesc.find(cur.get());
+        if(it!=cache.byDesc.end()) {
+            // fetch cache, without encoding
+            to_wire(buf, uint8_t(0xfe));
+            to_wire(buf, it->second.second);
+            return;
+        }
+    }
+
+    std::vector<uint8_t> encoded;
+    {
+        VectorOutBuf S(buf.be, encoded);
+        to_wire(S, cur.get());
+        if(!S.good()) {
+            buf.fault();
+            return;
+        }
+        encoded.resize(S.consumed());
+    }
+
+    auto it = cache.keys.find(encoded);
+    const bool define = it==cache.keys.end();
+    if(define) {
+        if(cache.keys.size() >= 0x10000) {
+            // cache full.  send in full
+            _to_wire_bulk(buf, encoded.data(), 1u, encoded.size(), false);
+            return;
+        }
+        uint16_t key = cache.keys.size();
+        it = cache.keys.emplace(std::move(encoded), key).first;
+    }
+
+    // only a shortcut, so bound the number of types kept alive
+    if(cache.byDesc.size() >= 1024u)
+        cache.byDesc.clear();
+    cache.byDesc.emplace(cur.get(), std::make_pair(cur, it->second));
+
+    if(define) {
+        // update cache
+        to_wire(buf, uint8_t(0xfd));
+        to_wire(buf, it->second);
+        _to_wire_bulk(buf, it->first.data(), 1u, it->first.size(), false);
+
+    } else {
+        // fetch cache.  An equivalent type was sent before.
+        to_wire(buf, uint8_t(0xfe));
+        to_wire(buf, it->second);
+    }
+}
+
 void from_wire(Buffer& buf, std::vector<FieldDesc>& descs, TypeStore& cache, unsigned depth)
 {
     if(!buf.good() || depth>20) {
@@ -180,16 +238,21 @@ void from_wire(Buffer& buf, std::vector<FieldDesc>& descs, TypeStore& cache, uns
 
                 // update field refs.
                 fld.miter.emplace_back(name, cindex-cref);
-                fld.mlookup[name] = cindex-cref;
+                fld.mlookup.insert(name, cindex-cref);
                 name+='.';
 
                 if(code.code==TypeCode::Struct && code==cfld.code) {
                     // copy decendent indicies for sub-struct
                     for(auto& pair : cfld.mlookup) {
-                        fld.mlookup[name+pair.first] = cindex - cref + pair.second;
+                        fld.mlookup.insert(name, pair.first, cindex - cref + pair.second);
                     }
                 }
             }
+
+            descs[index].mlookup.sort();
+
+            if(code.code==TypeCode::Struct)
+                build_plan(&descs[index]);
         }
             break;
         default:
@@ -219,8 +282,17 @@ void from_wire(Buffer& buf, std::vector<FieldDesc>& descs, TypeStore& cache, uns
 }
 
 namespace {
+// numeric arrays whose in-memory and wire representations are the same
+// are copied in bulk, with byte order swapped as necessary.
+template<typename E, typename C>
+struct isBulk : std::integral_constant<bool, std::is_same<E, C>::value
+                                             && std::is_arithmetic<E>::value
+                                             && !std::is_same<E, bool>::value>
+{};
+
 template<typename E, typename C = E>
-void to_wire(Buffer& buf, const shared_array<const void>& varr)
+typename std::enable_if<!isBulk<E, C>::value>::type
+to_wire(Buffer& buf, const shared_array<const void>& varr)
 {
     auto arr = varr.castTo<const E>();
     to_wire(buf, Size{arr.size()});
@@ -230,7 +302,23 @@ void to_wire(Buffer& buf, const shared_array<const void>& varr)
 }
 
 template<typename E, typename C = E>
-void from_wire(Buffer& buf, shared_array<const void>& varr)
+typename std::enable_if<isBulk<E, C>::value>::type
+to_wire(Buffer& buf, const shared_array<const void>& varr)
+{
+    auto arr = varr.castTo<const E>();
+    to_wire(buf, Size{arr.size()});
+    auto mem = reinterpret_cast<const uint8_t*>(arr.data());
+
+    // send array in place when no byte swap is needed
+    if((sizeof(E)==1u || buf.be==hostBE) && buf.reference(mem, arr.size()*sizeof(E), varr.dataPtr()))
+        return;
+
+    _to_wire_bulk(buf, mem, sizeof(E), arr.size(), buf.be ^ hostBE);
+}
+
+template<typename E, typename C = E>
+typename std::enable_if<!isBulk<E, C>::value>::type
+from_wire(Buffer& buf, shared_array<const void>& varr)
 {
     Size slen{};
     from_wire(buf, slen);
@@ -242,24 +330,209 @@ void from_wire(Buffer& buf, shared_array<const void>& varr)
     }
     varr = arr.freeze().template castTo<const void>();
 }
+
+template<typename E, typename C = E>
+typename std::enable_if<isBulk<E, C>::value>::type
+from_wire(Buffer& buf, shared_array<const void>& varr)
+{
+    Size slen{};
+    from_wire(buf, slen);
+    if(!buf.good())
+        return;
+
+    if(sizeof(E)==1u || buf.be==hostBE) {
+        // try to reference the received bytes in place
+        if(auto mem = buf.detach(slen.size*sizeof(E), alignof(E))) {
+            varr = shared_array<const E>(mem, reinterpret_cast<const E*>(mem.get()), slen.size)
+                    .template castTo<const void>();
+            return;
+        }
+    }
+
+    shared_array<E> arr(slen.size);
+    _from_wire_bulk(buf, reinterpret_cast<uint8_t*>(arr.data()), sizeof(E), arr.size(), buf.be ^ hostBE);
+    varr = arr.freeze().template castTo<const void>();
+}
+}
+
+void build_plan(FieldDesc* desc)
+{
+    assert(desc->code==TypeCode::Struct);
+
+    desc->plan.resize(desc->size()-1u);
+
+    for(auto i : range(desc->plan.size())) {
+        auto& op = desc->plan[i];
+        auto code = desc[1u+i].code;
+
+        op.width = 0u;
+        switch(code.code) {
+        case TypeCode::Struct:
+            op.kind = EncodeOp::Skip;
+            break;
+        case TypeCode::Float32:
+        case TypeCode::Float64:
+            op.kind = EncodeOp::Real;
+            op.width = code.size();
+            break;
+        case TypeCode::Int8:
+        case TypeCode::Int16:
+        case TypeCode::Int32:
+        case TypeCode::Int64:
+        case TypeCode::UInt8:
+        case TypeCode::UInt16:
+        case TypeCode::UInt32:
+        case TypeCode::UInt64:
+            op.kind = EncodeOp::Integer;
+            op.width = code.size();
+            break;
+        case TypeCode::Bool:
+            op.kind = EncodeOp::Bool;
+            op.width = 1u;
+            break;
+        case TypeCode::String:
+            op.kind = EncodeOp::String;
+            break;
+        default:
+            op.kind = EncodeOp::Other;
+            break;
+        }
+    }
+
+    // find sequences of fixed width steps
+    for(size_t i=0, N=desc->plan.size(); i<N;) {
+        auto& first = desc->plan[i];
+        first.run = 0u;
+        if(first.kind>EncodeOp::Bool) {
+            i++;
+            continue;
+        }
+        for(; i<N && desc->plan[i].kind<=EncodeOp::Bool; i++) {
+            first.run += desc->plan[i].width;
+            if(&desc->plan[i]!=&first)
+                desc->plan[i].run = 0u;
+        }
+    }
+}
+
+static
+void to_wire_field(Buffer& buf, const FieldDesc* desc, const FieldStorage* store);
+
+// serialize one step of a Struct plan
+static inline
+void to_wire_op(Buffer& buf, const EncodeOp& op, const FieldDesc* desc, const FieldStorage* store)
+{
+    switch(op.kind) {
+    case EncodeOp::Skip:
+        break;
+    case EncodeOp::Real:
+        if(op.width==4u)
+            to_wire(buf, float(store->as<double>()));
+        else
+            to_wire(buf, store->as<double>());
+        break;
+    case EncodeOp::Integer: {
+        // signed values are stored as int64_t, which truncates identically
+        auto fld = store->as<uint64_t>();
+        switch(op.width) {
+        case 1u: to_wire(buf, uint8_t (fld)); break;
+        case 2u: to_wire(buf, uint16_t(fld)); break;
+        case 4u: to_wire(buf, uint32_t(fld)); break;
+        default: to_wire(buf, uint64_t(fld)); break;
+        }
+    }
+        break;
+    case EncodeOp::Bool:
+        to_wire(buf, uint8_t(store->as<bool>()));
+        break;
+    case EncodeOp::String:
+        to_wire(buf, store->as<std::string>());
+        break;
+    case EncodeOp::Other:
+        to_wire_field(buf, desc, store);
+        break;
+    }
+}
+
+namespace {
+template<typename T>
+inline
+uint8_t* put(uint8_t* dst, T val, bool reverse)
+{
+    union {
+        T v;
+        uint8_t b[sizeof(T)];
+    } pun;
+    pun.v = val;
+    if(reverse) {
+        for(unsigned i=0; i<sizeof(T); i++)
+            dst[i] = pun.b[sizeof(T)-1-i];
+    } else {
+        memcpy(dst, pun.b, sizeof(T));
+    }
+    return dst+sizeof(T);
+}
+
+// write a fixed width step with space already ensure()d
+inline
+uint8_t* put_fixed(uint8_t* dst, const EncodeOp& op, const FieldStorage* store, bool reverse)
+{
+    switch(op.kind) {
+    case EncodeOp::Real:
+        if(op.width==4u)
+            return put(dst, float(store->as<double>()), reverse);
+        else
+            return put(dst, store->as<double>(), reverse);
+    case EncodeOp::Integer: {
+        auto fld = store->as<uint64_t>();
+        switch(op.width) {
+        case 1u: return put(dst, uint8_t (fld), reverse);
+        case 2u: return put(dst, uint16_t(fld), reverse);
+        case 4u: return put(dst, uint32_t(fld), reverse);
+        default: return put(dst, uint64_t(fld), reverse);
+        }
+    }
+    case EncodeOp::Bool:
+        return put(dst, uint8_t(store->as<bool>()), reverse);
+    default:
+        return dst;
+    }
+}
+} // namespace
+
+// serialize all members of a Struct
+static
+void to_wire_struct(Buffer& buf, const FieldDesc* desc, const FieldStorage* store)
+{
+    const bool reverse = buf.be ^ hostBE;
+    auto& plan = desc->plan;
+
+    for(size_t i=0, N=plan.size(); i<N;) {
+        if(plan[i].run && buf.ensure(plan[i].run)) {
+            // a sequence of fixed width fields.  write with a single bounds check.
+            auto start = buf.save();
+            auto dst = start;
+            for(; i<N && plan[i].kind<=EncodeOp::Bool; i++)
+                dst = put_fixed(dst, plan[i], store+1u+i, reverse);
+            buf._skip(dst-start);
+
+        } else {
+            to_wire_op(buf, plan[i], desc+1u+i, store+1u+i);
+            i++;
+        }
+    }
 }
 
 // serialize a field and all children (if Compound)
 static
-void to_wire_field(Buffer& buf, const FieldDesc* desc, const std::shared_ptr<const FieldStorage>& store)
+void to_wire_field(Buffer& buf, const FieldDesc* desc, const FieldStorage* store)
 {
     switch(store->code) {
     case StoreType::Null:
         switch(desc->code.code) {
-        case TypeCode::Struct: {
+        case TypeCode::Struct:
             // serialize entire sub-structure
-            for(auto off : range(desc->size())) {
-                auto cdesc = desc + off;
-                std::shared_ptr<const FieldStorage> cstore(store, store.get()+off); // TODO avoid shared_ptr/aliasing here
-                if(cdesc->code!=TypeCode::Struct)
-                    to_wire_field(buf, cdesc, cstore);
-            }
-        }
+            to_wire_struct(buf, desc, store);
             return;
         default: break;
         }
@@ -442,31 +715,230 @@ void to_wire_full(Buffer& buf, const Value& val)
 {
     assert(!!val);
 
-    to_wire_field(buf, Value::Helper::desc(val), Value::Helper::store(val));
+    to_wire_field(buf, Value::Helper::desc(val), Value::Helper::store_ptr(val));
 }
 
 void to_wire_valid(Buffer& buf, const Value& val, const BitMask* mask)
 {
     auto desc = Value::Helper::desc(val);
-    auto store = Value::Helper::store(val);
+    auto store = Value::Helper::store_ptr(val);
     assert(desc && desc->code==TypeCode::Struct);
     assert(!mask || mask->size()==desc->size());
 
     BitMask valid(desc->size());
-
-    for(auto bit : range(desc->size())) {
-        if((store.get()+bit)->valid && (!mask || (*mask)[bit]))
-            valid[bit] = true;
+    store->top->copyValid(valid, store->index());
+    if(mask) {
+        for(auto i : range(valid.wsize()))
+            valid.word(i) &= mask->word(i);
     }
 
     to_wire(buf, valid);
 
     for(auto bit : valid.onlySet()) {
-        std::shared_ptr<const FieldStorage> cstore(store, store.get()+bit);
-        to_wire_field(buf, desc+bit, cstore);
+        if(desc[bit].code==TypeCode::Struct)
+            to_wire_struct(buf, desc+bit, store+bit);
+        else
+            to_wire_op(buf, desc->plan[bit-1u], desc+bit, store+bit);
     }
 }
 
+namespace {
+// bytes needed to encode a Size
+inline
+size_t encoded_size(const Size& size)
+{
+    return size.size<254u || size.size==size_t(-1) ? 1u : 5u;
+}
+
+// bytes needed to encode a string.  cf. to_wire(Buffer&, const char*)
+inline
+size_t encoded_size(const std::string& s)
+{
+    auto len = strlen(s.c_str());
+    return encoded_size(Size{len}) + len;
+}
+
+// bytes needed to encode a type description.  cf. to_wire(Buffer&, const FieldDesc*)
+size_t encoded_size(const FieldDesc* cur)
+{
+    if(!cur)
+        return 1u;
+
+    size_t ret = 1u;
+
+    switch(cur->code.code) {
+    case TypeCode::StructA:
+    case TypeCode::UnionA:
+        ret += encoded_size(&cur->members[0]);
+        break;
+
+    case TypeCode::Struct:
+    case TypeCode::Union:
+        ret += encoded_size(cur->id);
+        ret += encoded_size(Size{cur->miter.size()});
+        for(auto& pair : cur->miter) {
+            ret += encoded_size(pair.first);
+            if(cur->code==TypeCode::Struct)
+                ret += encoded_size(cur+pair.second);
+            else
+                ret += encoded_size(&cur->members[pair.second]);
+        }
+        break;
+    default:
+        break;
+    }
+    return ret;
+}
+
+size_t encoded_size_field(const FieldDesc* desc, const FieldStorage* store);
+
+inline
+size_t encoded_size_op(const EncodeOp& op, const FieldDesc* desc, const FieldStorage* store)
+{
+    switch(op.kind) {
+    case EncodeOp::Skip:
+        return 0u;
+    case EncodeOp::Real:
+    case EncodeOp::Integer:
+    case EncodeOp::Bool:
+        return op.width;
+    case EncodeOp::String:
+        return encoded_size(store->as<std::string>());
+    case EncodeOp::Other:
+    default:
+        return encoded_size_field(desc, store);
+    }
+}
+
+size_t encoded_size_struct(const FieldDesc* desc, const FieldStorage* store)
+{
+    auto& plan = desc->plan;
+    size_t ret = 0u;
+
+    for(size_t i=0, N=plan.size(); i<N;) {
+        if(plan[i].run) {
+            ret += plan[i].run;
+            for(; i<N && plan[i].kind<=EncodeOp::Bool; i++) {}
+
+        } else {
+            ret += encoded_size_op(plan[i], desc+1u+i, store+1u+i);
+            i++;
+        }
+    }
+    return ret;
+}
+
+size_t encoded_size_elements(const shared_array<const void>& fld, bool withType)
+{
+    auto arr = fld.castTo<const Value>();
+    size_t ret = encoded_size(Size{arr.size()});
+    for(auto& elem : arr) {
+        ret += 1u;
+        if(elem) {
+            if(withType)
+                ret += encoded_size(Value::Helper::desc(elem));
+            ret += encoded_size_full(elem);
+        }
+    }
+    return ret;
+}
+
+size_t encoded_size_field(const FieldDesc* desc, const FieldStorage* store)
+{
+    switch(store->code) {
+    case StoreType::Null:
+        return desc->code==TypeCode::Struct ? encoded_size_struct(desc, store) : 0u;
+
+    case StoreType::Real:
+    case StoreType::Integer:
+    case StoreType::UInteger:
+    case StoreType::Bool:
+        return desc->code.size();
+
+    case StoreType::String:
+        return encoded_size(store->as<std::string>());
+
+    case StoreType::Compound: {
+        auto& fld = store->as<Value>();
+        if(!fld)
+            return 1u; // NULL Union or Any
+
+        if(desc->code==TypeCode::Union) {
+            size_t index = 0u;
+            for(auto& pair : desc->miter) {
+                if(Value::Helper::desc(fld)== &desc->members[pair.second])
+                    break;
+                index++;
+            }
+            return encoded_size(Size{index}) + encoded_size_full(fld);
+
+        } else { // Any
+            return encoded_size(Value::Helper::desc(fld)) + encoded_size_full(fld);
+        }
+    }
+
+    case StoreType::Array: {
+        auto& fld = store->as<shared_array<const void>>();
+        switch(desc->code.code) {
+        case TypeCode::StringA: {
+            auto arr = fld.castTo<const std::string>();
+            size_t ret = encoded_size(Size{arr.size()});
+            for(auto& elem : arr)
+                ret += encoded_size(elem);
+            return ret;
+        }
+        case TypeCode::StructA:
+        case TypeCode::UnionA:
+            return encoded_size_elements(fld, false);
+        case TypeCode::AnyA:
+            return encoded_size_elements(fld, true);
+        default:
+            // numeric, including BoolA as one byte per element
+            return encoded_size(Size{fld.size()}) + fld.size()*desc->code.scalarOf().size();
+        }
+    }
+    }
+    return 0u;
+}
+} // namespace
+
+size_t encoded_size_full(const Value& val)
+{
+    assert(!!val);
+
+    return encoded_size_field(Value::Helper::desc(val), Value::Helper::store_ptr(val));
+}
+
+size_t encoded_size_valid(const Value& val, const BitMask* mask)
+{
+    auto desc = Value::Helper::desc(val);
+    auto store = Value::Helper::store_ptr(val);
+    assert(desc && desc->code==TypeCode::Struct);
+    assert(!mask || mask->size()==desc->size());
+
+    // same selection as to_wire_valid(), without building the BitMask
+    size_t ret = 0u;
+    size_t nbytes = 0u;
+
+    const auto top = store->top;
+    const auto base = store->index();
+    const auto N = desc->size();
+
+    for(auto bit = top->findValid(base, base+N) - base; bit < N; bit = top->findValid(base+bit+1u, base+N) - base) {
+        if(mask && !(*mask)[bit])
+            continue;
+
+        nbytes = bit/8u + 1u;
+
+        if(desc[bit].code==TypeCode::Struct)
+            ret += encoded_size_struct(desc+bit, store+bit);
+        else
+            ret += encoded_size_op(desc->plan[bit-1u], desc+bit, store+bit);
+    }
+
+    return ret + encoded_size(Size{nbytes}) + nbytes;
+}
+
 namespace {
 template<typename T>
 T from_wire_as(Buffer& buf)
@@ -490,7 +962,7 @@ void from_wire_field(Buffer& buf, TypeStore& ctxt,  const FieldDesc* desc, const
                 std::shared_ptr<FieldStorage> cstore(store, store.get()+off); // TODO avoid shared_ptr/aliasing here
                 if(cdesc->code!=TypeCode::Struct) {
                     from_wire_field(buf, ctxt, cdesc, cstore);
-                    cstore->valid = true;
+                    cstore->valid(true);
                 }
             }
         }
@@ -738,7 +1210,7 @@ void from_wire_valid(Buffer& buf, TypeStore& ctxt, Value& val)
     BitMask valid;
     from_wire(buf, valid);
     // encoding rounds # of bits to whole bytes, so we may trim
-    valid.resize(top->members.size());
+    valid.resize(top->nmembers);
     if(!buf.good())
         return;
 
@@ -748,7 +1220,7 @@ void from_wire_valid(Buffer& buf, TypeStore& ctxt, Value& val)
         std::shared_ptr<FieldStorage> cstore(store, store.get()+bit);
         auto cdesc = desc + bit;
         from_wire_field(buf, ctxt, cdesc, cstore);
-        cstore->valid = true;
+        cstore->valid(true);
         bit = valid.findSet(bit + cdesc->size());
     }
 }
@@ -764,7 +1236,9 @@ void from_wire_type(Buffer& buf, TypeStore& ctxt, Value& val)
     if(!descs->empty()) {
 
         std::shared_ptr<const FieldDesc> stype(descs, descs->data()); // alias
-        val = Value::Helper::build(stype);
+        // once per operation.  Not done for each Any field value, which would
+        // hash every received type under a global lock.
+        val = Value::Helper::build(intern_type(stype));
 
     } else {
         val = Value();
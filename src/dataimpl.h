@@ -7,7 +7,14 @@
 #define DATAIMPL_H
 
 #include <string>
+#include <cstring>
+#include <ostream>
+#include <algorithm>
 #include <map>
+#include <vector>
+#include <atomic>
+
+#include <epicsMutex.h>
 
 #include <pvxs/data.h>
 #include <pvxs/sharedArray.h>
@@ -15,6 +22,9 @@
 #include "utilpvt.h"
 
 namespace pvxs {
+namespace impl {
+struct ValuePool;
+}
 
 struct Value::Helper {
     // internal access to private operations
@@ -29,6 +39,9 @@ struct Value::Helper {
 
     static Value build(const void* ptr, StoreType type);
 
+    //! Like proto.cloneEmpty(), with storage from pool (may be NULL)
+    static Value cloneEmpty(const Value& proto, const std::shared_ptr<impl::ValuePool>& pool);
+
     static inline       std::shared_ptr<impl::FieldStorage>& store(      Value& v) { return v.store; }
     static inline std::shared_ptr<const impl::FieldStorage>  store(const Value& v) { return v.store; }
     static constexpr const FieldDesc*                        desc(const Value& v) { return v.desc; }
@@ -42,6 +55,127 @@ struct Value::Helper {
 namespace impl {
 struct Buffer;
 
+/** One step in serializing the fields of a Struct.  cf. FieldDesc::plan
+ */
+struct EncodeOp {
+    enum Kind : uint8_t {
+        // fixed width
+        Skip,    // sub-Struct.  members follow
+        Real,    // double storage.  'width' is 4 or 8
+        Integer, // int64_t or uint64_t storage.  'width' is 1, 2, 4, or 8
+        Bool,
+        // variable width
+        String,
+        Other,   // Union, Any, and arrays.
+    };
+    Kind kind;
+    uint8_t width;
+    // For the first of a sequence of fixed width steps, the total width.  Otherwise zero.
+    uint32_t run;
+};
+
+//! Non-owning reference to a name stored in a NameTable
+struct NameRef {
+    const char* ptr;
+    size_t len;
+
+    inline std::string str() const { return std::string(ptr, len); }
+    inline operator std::string() const { return str(); }
+};
+
+inline
+std::ostream& operator<<(std::ostream& strm, const NameRef& name)
+{
+    strm.write(name.ptr, name.len);
+    return strm;
+}
+
+/** Sorted name -> index lookup table.
+ *
+ * All names are stored back to back in a single arena string,
+ * with a flat array of (offset, length, index) sorted by name.
+ * Compared with a std::map<std::string, size_t> this needs two
+ * allocations per table instead of one (or two) per entry,
+ * and lookups are a binary search over contiguous memory.
+ *
+ * Filled by insert() then sort(), which must be called before find().
+ * Iteration is in lexical order, and entries are immutable once sorted.
+ */
+class PVXS_API NameTable {
+    struct Entry {
+        uint32_t offset;
+        uint32_t length;
+        size_t index;
+    };
+    std::string arena;
+    std::vector<Entry> entries;
+
+    inline int compare(const Entry& ent, const char* name, size_t len) const {
+        auto n = std::min(size_t(ent.length), len);
+        int ret = n ? memcmp(arena.data()+ent.offset, name, n) : 0;
+        if(ret==0)
+            ret = ent.length < len ? -1 : ent.length > len ? 1 : 0;
+        return ret;
+    }
+public:
+    struct value_type {
+        NameRef first;
+        size_t second;
+    };
+
+    class const_iterator {
+        friend class NameTable;
+        const NameTable* table;
+        size_t pos;
+        value_type cur;
+        inline const_iterator(const NameTable* table, size_t pos) :table(table), pos(pos) { fill(); }
+        inline void fill() {
+            if(pos < table->entries.size()) {
+                auto& ent = table->entries[pos];
+                cur.first.ptr = table->arena.data()+ent.offset;
+                cur.first.len = ent.length;
+                cur.second = ent.index;
+            }
+        }
+    public:
+        inline const value_type& operator*() const { return cur; }
+        inline const value_type* operator->() const { return &cur; }
+        inline const_iterator& operator++() { pos++; fill(); return *this; }
+        inline bool operator==(const const_iterator& o) const { return pos==o.pos; }
+        inline bool operator!=(const const_iterator& o) const { return pos!=o.pos; }
+    };
+
+    inline const_iterator begin() const { return const_iterator(this, 0u); }
+    inline const_iterator end() const { return const_iterator(this, entries.size()); }
+    inline size_t size() const { return entries.size(); }
+    inline bool empty() const { return entries.empty(); }
+
+    //! Lookup by name.  Returns end() if not found.
+    inline const_iterator find(const char* name, size_t len) const {
+        size_t lo = 0u, hi = entries.size();
+        while(lo < hi) {
+            auto mid = lo + (hi-lo)/2u;
+            int cmp = compare(entries[mid], name, len);
+            if(cmp==0)
+                return const_iterator(this, mid);
+            else if(cmp < 0)
+                lo = mid+1u;
+            else
+                hi = mid;
+        }
+        return end();
+    }
+    inline const_iterator find(const std::string& name) const { return find(name.data(), name.size()); }
+    inline const_iterator find(const NameRef& name) const { return find(name.ptr, name.len); }
+
+    //! Append an entry.  Must be followed by sort().
+    void insert(const std::string& name, size_t index);
+    //! Append an entry named prefix+name.  Must be followed by sort().
+    void insert(const std::string& prefix, const NameRef& name, size_t index);
+    //! Order entries for lookup.  If a name was inserted more than once, the last index is kept.
+    void sort();
+};
+
 /** Describes a single field, leaf or otherwise, in a nested structure.
  *
  * FieldDesc are always stored depth first as a contigious array,
@@ -62,11 +196,15 @@ struct FieldDesc {
     // "fld.sub.leaf" -> rel index
     // For Struct, relative to this
     // For Union, offset in members array
-    std::map<std::string, size_t> mlookup;
+    NameTable mlookup;
 
     // child iteration.  child# -> ("sub", rel index in enclosing vector<FieldDesc>)
     std::vector<std::pair<std::string, size_t>> miter;
 
+    // Reverse of mlookup.  rel index -> "fld.sub.leaf"
+    // Built on first use by Value::nameOf(), then never changed.  Access with std::atomic_load()
+    mutable std::shared_ptr<const std::vector<std::string>> mnames;
+
     // number of FieldDesc nodes between this node and it's a parent Struct (or 0 if no parent).
     // This value also appears in the parent's miter and mlookup mappings.
     // Only usable when a StructTop is accessible and this!=StructTop::desc
@@ -79,6 +217,10 @@ struct FieldDesc {
 
     TypeCode code{TypeCode::Null};
 
+    // For Struct, serialization steps for all decendent fields.
+    // plan[i] describes this[i+1].  cf. build_plan()
+    std::vector<EncodeOp> plan;
+
     // number of FieldDesc nodes which describe this node.  Inclusive.  always size()>=1
     inline size_t size() const { return 1u + (members.empty() ? mlookup.size() : 0u); }
 };
@@ -86,11 +228,45 @@ struct FieldDesc {
 PVXS_API
 void to_wire(Buffer& buf, const FieldDesc* cur);
 
+//! Fill in FieldDesc::plan of a Struct, once all decendents are added.
+void build_plan(FieldDesc* desc);
+
 typedef std::map<uint16_t, std::vector<FieldDesc>> TypeStore;
 
+// Type descriptions already sent to a peer.
+struct TxTypeStore {
+    // encoded description -> cache key
+    std::map<std::vector<uint8_t>, uint16_t> keys;
+    // Recently sent types -> cache key, to skip encoding on repeat.
+    // Holds a reference so that an address is not reused by another type.
+    std::map<const FieldDesc*, std::pair<std::shared_ptr<const FieldDesc>, uint16_t>> byDesc;
+
+    //! number of cache keys assigned
+    size_t size() const { return keys.size(); }
+};
+
+//! serialize type description.  Send a cache key if previously sent.
+PVXS_API
+void to_wire(Buffer& buf, const std::shared_ptr<const FieldDesc>& cur, TxTypeStore& cache);
+
 PVXS_API
 void from_wire(Buffer& buf, std::vector<FieldDesc>& descs, TypeStore& cache, unsigned depth=0);
 
+/** Return the process-wide shared instance of a type equivalent to desc.
+ *
+ * Types are compared structurally (codes, IDs, and member names),
+ * so that all decoded copies of one type share a single FieldDesc tree,
+ * and Value::compareType() of identical received types is true.
+ * desc becomes the shared instance if no equivalent is in use.
+ * Only weak references are kept.
+ */
+PVXS_API
+std::shared_ptr<const FieldDesc> intern_type(const std::shared_ptr<const FieldDesc>& desc);
+
+//! Number of types currently held by intern_type()
+PVXS_API
+size_t intern_type_count();
+
 struct StructTop;
 
 struct FieldStorage {
@@ -112,14 +288,17 @@ struct FieldStorage {
     >::type store;
     // index of this field in StructTop::members
     StructTop *top;
-    bool valid=false;
     StoreType code=StoreType::Null;
 
     void init(StoreType code);
     void deinit();
     ~FieldStorage();
 
-    size_t index() const;
+    inline size_t index() const;
+
+    // is this field marked.  cf. StructTop::valid
+    inline bool valid() const;
+    inline void valid(bool v);
 
     template<typename T>
     T& as() { return *reinterpret_cast<T*>(&store); }
@@ -135,15 +314,77 @@ struct StructTop {
     // type of first top level struct.  always !NULL.
     // Actually the first element of a vector<const FieldDesc>
     std::shared_ptr<const FieldDesc> desc;
-    // our members (inclusive).  always size()>=1
-    std::vector<FieldStorage> members;
+    // our members (inclusive).  always nmembers>=1.
+    // Allocated in the same block as this StructTop.  cf. Value::Value()
+    FieldStorage* members = nullptr;
+    size_t nmembers = 0u;
+
+    // packed "marked" flags of members[].  bit i for members[i].
+    // vwords() words, allocated in the same block as members[].
+    uint64_t* valid = nullptr;
 
     // empty, or the field of a structure which encloses this.
     std::weak_ptr<FieldStorage> enclosing;
 
+    // set by Value::freeze().  never cleared.
+    bool frozen = false;
+
+    StructTop() = default;
+    StructTop(const StructTop&) = delete;
+    StructTop& operator=(const StructTop&) = delete;
+    ~StructTop();
+
+    inline size_t vwords() const { return (nmembers+63u)/64u; }
+    inline bool isValid(size_t i) const { return valid[i/64u] & (uint64_t(1u)<<(i%64u)); }
+    inline void setValid(size_t i, bool v) {
+        if(v)
+            valid[i/64u] |= uint64_t(1u)<<(i%64u);
+        else
+            valid[i/64u] &= ~(uint64_t(1u)<<(i%64u));
+    }
+    // index of first marked member in [first, last), or last
+    size_t findValid(size_t first, size_t last) const;
+    // any member in [first, last) is marked
+    inline bool anyValid(size_t first, size_t last) const { return findValid(first, last)!=last; }
+    // unmark members in [first, last)
+    void clearValid(size_t first, size_t last);
+    // mask[i] = isValid(first+i) for i in [0, mask.size())
+    void copyValid(BitMask& mask, size_t first) const;
+
     INST_COUNTER(StructTop);
 };
 
+size_t FieldStorage::index() const { return this-top->members; }
+bool FieldStorage::valid() const { return top->isValid(index()); }
+void FieldStorage::valid(bool v) { top->setValid(index(), v); }
+
+/** Recycles the storage of Values.
+ *
+ *  Each StructTop, with all of its FieldStorage, is a single allocation whose size
+ *  depends on the number of fields.  cf. Value::Value()
+ *  Values created through Value::Helper::cloneEmpty() with a pool return
+ *  this block to the pool when the last reference is released.  The pool
+ *  keeps up to 'limit' unused blocks of each size.
+ */
+struct PVXS_API ValuePool {
+    const size_t limit;
+    // allocations satisfied from, or not from, unused blocks
+    std::atomic<size_t> hits{}, misses{};
+
+    explicit ValuePool(size_t limit);
+    ValuePool(const ValuePool&) = delete;
+    ValuePool& operator=(const ValuePool&) = delete;
+    ~ValuePool();
+
+    void* allocate(size_t nbytes);
+    void release(void* block, size_t nbytes);
+
+private:
+    epicsMutex lock;
+    // block size -> unused blocks
+    std::map<size_t, std::vector<void*>> unused;
+};
+
 using Type = std::shared_ptr<const FieldDesc>;
 
 
@@ -155,6 +396,14 @@ void to_wire_full(Buffer& buf, const Value& val);
 PVXS_API
 void to_wire_valid(Buffer& buf, const Value& val, const BitMask* mask=nullptr);
 
+//! Number of bytes to_wire_full() will write
+PVXS_API
+size_t encoded_size_full(const Value& val);
+
+//! Number of bytes to_wire_valid() will write
+PVXS_API
+size_t encoded_size_valid(const Value& val, const BitMask* mask=nullptr);
+
 //! deserialize type description
 PVXS_API
 void from_wire_type(Buffer& buf, TypeStore& ctxt, Value& val);
@@ -19,6 +19,14 @@
 #include <event2/event.h>
 #include <event2/thread.h>
 
+#if defined(__AVX2__)
+#  include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#  include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#  include <arm_neon.h>
+#endif
+
 #include <errlog.h>
 #include <osiSock.h>
 #include <epicsEvent.h>
@@ -38,6 +46,14 @@ typedef epicsGuard<epicsMutex> Guard;
 static constexpr
 size_t min_slice_size = 1024u;
 
+// EvInBuf::detach() will copy blocks smaller than this
+static constexpr
+size_t min_detach_size = 1024u;
+
+// EvOutBuf::reference() will copy blocks smaller than this
+static constexpr
+size_t min_reference_size = 4096u;
+
 namespace pvxs {namespace impl {
 
 DEFINE_LOGGER(logerr, "pvxs.loop");
@@ -454,8 +470,153 @@ void from_wire(Buffer &buf, SockAddr& val)
 }
 
 
+namespace {
+
+// copy 'count' elements of size N from src to dst, reversing the byte order of each.
+template<size_t N>
+void swapN(uint8_t* dst, const uint8_t* src, size_t count)
+{
+    for(size_t i=0; i<count; i++, dst+=N, src+=N) {
+        for(size_t b=0; b<N; b++)
+            dst[b] = src[N-1u-b];
+    }
+}
+
+#if defined(__AVX2__)
+template<size_t N> struct swapMask;
+template<> struct swapMask<2> { static __m256i get() { return _mm256_setr_epi8(1,0,3,2,5,4,7,6,9,8,11,10,13,12,15,14,
+                                                                                 1,0,3,2,5,4,7,6,9,8,11,10,13,12,15,14); } };
+template<> struct swapMask<4> { static __m256i get() { return _mm256_setr_epi8(3,2,1,0,7,6,5,4,11,10,9,8,15,14,13,12,
+                                                                                 3,2,1,0,7,6,5,4,11,10,9,8,15,14,13,12); } };
+template<> struct swapMask<8> { static __m256i get() { return _mm256_setr_epi8(7,6,5,4,3,2,1,0,15,14,13,12,11,10,9,8,
+                                                                                 7,6,5,4,3,2,1,0,15,14,13,12,11,10,9,8); } };
+
+template<size_t N>
+void swapVec(uint8_t* dst, const uint8_t* src, size_t count)
+{
+    const __m256i mask(swapMask<N>::get());
+    size_t nvec = (count*N)/32u;
+    for(size_t i=0; i<nvec; i++, src+=32, dst+=32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)src);
+        _mm256_storeu_si256((__m256i*)dst, _mm256_shuffle_epi8(v, mask));
+    }
+    swapN<N>(dst, src, count - nvec*(32u/N));
+}
+
+#elif defined(__SSE2__) || defined(_M_X64)
+EPICS_ALWAYS_INLINE __m128i swap16(__m128i v)
+{
+    return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+}
+
+template<size_t N> __m128i swapOne(__m128i v);
+template<> EPICS_ALWAYS_INLINE __m128i swapOne<2>(__m128i v) { return swap16(v); }
+template<> EPICS_ALWAYS_INLINE __m128i swapOne<4>(__m128i v) {
+    v = swap16(v);
+    v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2,3,0,1));
+    return _mm_shufflehi_epi16(v, _MM_SHUFFLE(2,3,0,1));
+}
+template<> EPICS_ALWAYS_INLINE __m128i swapOne<8>(__m128i v) {
+    v = swap16(v);
+    v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(0,1,2,3));
+    return _mm_shufflehi_epi16(v, _MM_SHUFFLE(0,1,2,3));
+}
+
+template<size_t N>
+void swapVec(uint8_t* dst, const uint8_t* src, size_t count)
+{
+    size_t nvec = (count*N)/16u;
+    for(size_t i=0; i<nvec; i++, src+=16, dst+=16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)src);
+        _mm_storeu_si128((__m128i*)dst, swapOne<N>(v));
+    }
+    swapN<N>(dst, src, count - nvec*(16u/N));
+}
+
+#elif defined(__ARM_NEON)
+template<size_t N> uint8x16_t swapOne(uint8x16_t v);
+template<> EPICS_ALWAYS_INLINE uint8x16_t swapOne<2>(uint8x16_t v) { return vrev16q_u8(v); }
+template<> EPICS_ALWAYS_INLINE uint8x16_t swapOne<4>(uint8x16_t v) { return vrev32q_u8(v); }
+template<> EPICS_ALWAYS_INLINE uint8x16_t swapOne<8>(uint8x16_t v) { return vrev64q_u8(v); }
+
+template<size_t N>
+void swapVec(uint8_t* dst, const uint8_t* src, size_t count)
+{
+    size_t nvec = (count*N)/16u;
+    for(size_t i=0; i<nvec; i++, src+=16, dst+=16) {
+        vst1q_u8(dst, swapOne<N>(vld1q_u8(src)));
+    }
+    swapN<N>(dst, src, count - nvec*(16u/N));
+}
+
+#else
+template<size_t N>
+EPICS_ALWAYS_INLINE void swapVec(uint8_t* dst, const uint8_t* src, size_t count)
+{
+    swapN<N>(dst, src, count);
+}
+#endif
+
+void swapCopy(uint8_t* dst, const uint8_t* src, size_t esize, size_t count, bool reverse)
+{
+    if(!reverse || esize==1u) {
+        memcpy(dst, src, esize*count);
+        return;
+    }
+    switch(esize) {
+    case 2: swapVec<2>(dst, src, count); break;
+    case 4: swapVec<4>(dst, src, count); break;
+    case 8: swapVec<8>(dst, src, count); break;
+    default:
+        throw std::logic_error("Unsupported element size");
+    }
+}
+
+} // namespace
+
+void _to_wire_bulk(Buffer& buf, const uint8_t *mem, size_t esize, size_t count, bool reverse)
+{
+    // hint for a single contiguous segment.
+    // On failure, fall back to filling whatever is available.
+    if(count)
+        (void)buf.ensure(esize*count);
+
+    while(count) {
+        if(!buf.ensure(esize)) {
+            buf.fault();
+            return;
+        }
+        size_t n = std::min(count, buf.size()/esize);
+        swapCopy(buf.save(), mem, esize, n, reverse);
+        buf._skip(n*esize);
+        mem += n*esize;
+        count -= n;
+    }
+}
+
+void _from_wire_bulk(Buffer& buf, uint8_t *mem, size_t esize, size_t count, bool reverse)
+{
+    // only request one element at a time to avoid a large pullup() in EvInBuf
+    while(count) {
+        if(!buf.ensure(esize)) {
+            buf.fault();
+            return;
+        }
+        size_t n = std::min(count, buf.size()/esize);
+        swapCopy(mem, buf.save(), esize, n, reverse);
+        buf._skip(n*esize);
+        mem += n*esize;
+        count -= n;
+    }
+}
+
+
 bool Buffer::refill(size_t more) { return false; }
 
+std::shared_ptr<const uint8_t> Buffer::detach(size_t len, size_t align) { return nullptr; }
+
+bool Buffer::reference(const uint8_t* mem, size_t len, const std::shared_ptr<const void>& owner) { return false; }
+
 FixedBuf::~FixedBuf() {}
 
 VectorOutBuf::~VectorOutBuf() {}
@@ -505,6 +666,30 @@ bool EvOutBuf::refill(size_t more)
     return true;
 }
 
+static
+void releaseReference(const void *data, size_t datalen, void *extra)
+{
+    delete static_cast<std::shared_ptr<const void>*>(extra);
+}
+
+bool EvOutBuf::reference(const uint8_t* mem, size_t len, const std::shared_ptr<const void>& owner)
+{
+    if(err || len < min_reference_size)
+        return false;
+
+    // commit anything written so far.  Next ensure() reserves after the reference.
+    if(!refill(0))
+        return false;
+
+    std::unique_ptr<std::shared_ptr<const void>> holder(new std::shared_ptr<const void>(owner));
+
+    if(evbuffer_add_reference(backing, mem, len, &releaseReference, holder.get()))
+        throw std::bad_alloc();
+
+    holder.release(); // now owned by backing
+    return true;
+}
+
 EvInBuf::~EvInBuf() { refill(0); }
 
 bool EvInBuf::refill(size_t needed)
@@ -549,6 +734,49 @@ bool EvInBuf::refill(size_t needed)
     return true;
 }
 
+std::shared_ptr<const uint8_t> EvInBuf::detach(size_t len, size_t align)
+{
+    if(err || len < min_detach_size)
+        return nullptr;
+
+    // drain consumed
+    if(base && evbuffer_drain(backing, pos-base))
+        throw std::bad_alloc();
+
+    limit = base = pos = nullptr;
+
+    // only possible if the block lies entirely within the first chain
+    evbuffer_iovec vec;
+    auto n = evbuffer_peek(backing, -1, nullptr, &vec, 1);
+    if(n<=0)
+        return nullptr;
+
+    // unless we detach, continue reading from the first chain, as refill() would
+    base = pos = (uint8_t*)vec.iov_base;
+    limit = base+vec.iov_len;
+
+    if(vec.iov_len < len || size_t(vec.iov_base)%align)
+        return nullptr;
+
+    // steal the whole chain (no copy) and put back any trailing bytes.
+    // Only worthwhile if the trailing bytes are fewer than the block.
+    size_t tail = vec.iov_len - len;
+    if(tail >= len)
+        return nullptr;
+
+    limit = base = pos = nullptr;
+
+    evbuf chain(evbuffer_new());
+    if(evbuffer_remove_buffer(backing, chain.get(), vec.iov_len)!=int(vec.iov_len))
+        throw std::bad_alloc();
+
+    if(tail && evbuffer_prepend(backing, (const uint8_t*)vec.iov_base + len, tail))
+        throw std::bad_alloc();
+
+    std::shared_ptr<evbuffer> owner(chain.release(), evbuffer_free);
+    return std::shared_ptr<const uint8_t>(owner, (const uint8_t*)vec.iov_base);
+}
+
 void to_evbuf(evbuffer *buf, const Header& H, bool be)
 {
     EvOutBuf M(be, buf, 8);
@@ -14,6 +14,7 @@
 #include <string>
 #include <type_traits>
 #include <initializer_list>
+#include <memory>
 
 #include <type_traits>
 
@@ -78,6 +79,25 @@ public:
     EPICS_ALWAYS_INLINE void _skip(size_t i) { pos+=i; }
 
     uint8_t* save() const { return pos; }
+
+    /** Remove the next 'len' bytes as a contiguous block which remains
+     *  valid independently of this Buffer.  The block address will be a
+     *  multiple of 'align'.
+     *
+     *  Returns nullptr if not possible, or not cheaper than a copy.
+     *  The unread bytes are unchanged in this case, and may be read as usual.
+     *  Bytes already read may have been released, as by refill(),
+     *  so pointers from save() are no longer valid.
+     */
+    virtual std::shared_ptr<const uint8_t> detach(size_t len, size_t align);
+
+    /** Append 'len' bytes from 'mem' without copying.  'owner' is held
+     *  until these bytes are no longer needed.
+     *
+     *  Returns false if not possible, or not cheaper than a copy.
+     *  The Buffer is unchanged in this case.
+     */
+    virtual bool reference(const uint8_t* mem, size_t len, const std::shared_ptr<const void>& owner);
 };
 
 //! (de)serialization to/from buffers which are fixed size and contigious
@@ -127,6 +147,7 @@ public:
     {refill(isize);}
     virtual ~EvOutBuf();
     virtual bool refill(size_t more) override final;
+    virtual bool reference(const uint8_t* mem, size_t len, const std::shared_ptr<const void>& owner) override final;
 };
 
 //! deserialize from an evbuffer, possibly segmented
@@ -145,6 +166,7 @@ public:
     virtual ~EvInBuf();
 
     virtual bool refill(size_t more) override final;
+    virtual std::shared_ptr<const uint8_t> detach(size_t len, size_t align) override final;
 };
 
 // assumes prior buf.ensure(M) where M>=N
@@ -188,6 +210,23 @@ inline void _from_wire(Buffer& buf, uint8_t *mem, bool reverse)
     buf._skip(N);
 }
 
+/** Bulk copy of an array of fixed size elements into buf.
+ *
+ * Equivalent to calling _to_wire<esize>() for each element,
+ * but copies as many elements as will fit into each contiguous
+ * segment of buf.
+ *
+ * @param buf output buffer
+ * @param mem first of 'count' elements, each of 'esize' bytes (1, 2, 4, or 8)
+ * @param reverse byte order mis-match, typically buf.be ^ hostBE
+ */
+PVXS_API
+void _to_wire_bulk(Buffer& buf, const uint8_t *mem, size_t esize, size_t count, bool reverse);
+
+//! Bulk copy of an array of fixed size elements from buf.  cf. _to_wire_bulk()
+PVXS_API
+void _from_wire_bulk(Buffer& buf, uint8_t *mem, size_t esize, size_t count, bool reverse);
+
 /** Write sizeof(T) bytes from buf from val
  *
  * @param buf output buffer.  buf[0] through buf[sizeof(T)-1] must be valid.
@@ -30,7 +30,7 @@ BitMask request2mask(const FieldDesc* desc, const Value& pvRequest)
 
             if(crdesc->code==TypeCode::Struct) {
                 // attempt to match up with actual structure
-                auto it = desc->mlookup.find(pair.first);
+                auto it(desc->mlookup.find(pair.first));
                 if(it!=desc->mlookup.end()) {
                     // match found
                     auto cdesc = desc + it->second;
@@ -362,6 +362,15 @@ public:
      */
     void cacheClear();
 
+    //! Counters of storage reuse for monitor updates.  cf. Config::valuePoolLimit
+    struct PoolStats {
+        //! Updates decoded into recycled storage
+        size_t hits = 0u;
+        //! Updates which needed a new allocation
+        size_t misses = 0u;
+    };
+    PoolStats poolStats() const;
+
     explicit operator bool() const { return pvt.operator bool(); }
     size_t use_count() const { return pvt.use_count(); }
 private:
@@ -625,6 +634,12 @@ struct PVXS_API Config {
     //! Whether to extend the addressList with local interface broadcast addresses.  (recommended)
     bool autoAddrList = true;
 
+    //! Number of unused monitor update Values of each size kept for reuse.  Zero disables reuse.  cf. EPICS_PVA_VALUE_POOL
+    size_t valuePoolLimit = 16u;
+
+    //! Bytes of following messages which may be read along with the current message.  At least 8.
+    size_t tcp_readahead = 0x1000u;
+
     //! Default configuration using process environment
     static Config from_env();
 
@@ -445,6 +445,8 @@ struct PVXS_API NoConvert : public std::runtime_error
     virtual ~NoConvert();
 };
 
+class FieldRef;
+
 /** Generic data container
  *
  * References a single data field, which may be free-standing (eg. "int x = 5;")
@@ -501,8 +503,29 @@ public:
     //! copy value(s) from other.
     //! Acts like from(o) for kind==Kind::Compound .
     //! Acts like from(o.as<T>()) for kind!=Kind::Compound
+    //! For a Struct, only marked fields of o are copied.
+    //! When o has exactly the same type, fields are copied by position without name lookups.
     Value& assign(const Value& o);
 
+    /** Make this structure read-only, so that it may be shared as a snapshot.
+     *
+     * Applies to the whole enclosing structure, through all references,
+     * and to any values held by Union, Any, or Struct/Union/Any array members.
+     * Member values which are also referenced elsewhere, eg. shared by clone(),
+     * are first replaced with copies, so that only this structure is frozen.
+     * Subsequent attempts to change or (un)mark fields throw std::logic_error.
+     * Use thaw() to obtain a modifiable copy.
+     *
+     * @code
+     * Value snap = val.clone().freeze(); // may now be shared between threads
+     * @endcode
+     */
+    Value& freeze();
+    //! True if freeze() has been called
+    bool isFrozen() const;
+    //! Return *this if not isFrozen(), or a modifiable clone()
+    Value thaw() const;
+
     //! Use to allocate members for an array of Struct and array of Union
     Value allocMember();
 
@@ -531,6 +554,11 @@ public:
     //! test for instance equality.
     inline bool compareInst(const Value& o) const { return store==o.store; }
 //    int compareValue(const Value&) const;
+    /** test for type equality.
+     * Top level types received from the network are shared when structurally identical,
+     * so this is true for identical types received on different channels.
+     * The types of received Any field values are not shared.
+     */
     inline int compareType(const Value& o) const { return desc==o.desc; }
 
     /** Return our name for a decendent field.
@@ -551,6 +579,9 @@ public:
     bool tryCopyOut(void *ptr, StoreType type) const;
     void copyIn(const void *ptr, StoreType type);
     bool tryCopyIn(const void *ptr, StoreType type);
+    // as (*this)[ref].copyOut(), without a temporary Value for scalar and string fields
+    void copyOut(const FieldRef& ref, void *ptr, StoreType type) const;
+    void copyIn(const FieldRef& ref, const void *ptr, StoreType type);
 
     /** Extract from field.
      *
@@ -663,6 +694,14 @@ public:
     const Value operator[](const char *name) const;
     inline const Value operator[](const std::string& name) const { return (*this)[name.c_str()]; }
 
+    /** Access a decendant field through a previously resolved FieldRef.
+     *
+     * Constant time when this Value has the type the FieldRef was resolved against.
+     * Otherwise equivalent to operator[] with the original name.
+     */
+    Value operator[](const FieldRef& ref);
+    const Value operator[](const FieldRef& ref) const;
+
     template<typename V>
     class Iterable;
 private:
@@ -792,6 +831,296 @@ Value::Iterable<const Value> Value::iall() const      { return Iterable<const Va
 Value::Iterable<const Value> Value::ichildren() const { return Iterable<const Value>{*this, false, false}; }
 Value::Iterable<const Value> Value::imarked() const   { return Iterable<const Value>{*this, true , true}; }
 
+/** A decendant field of a Struct, resolved once from a name.
+ *
+ * Finding a field with Value::operator[](const char*) parses the name,
+ * and searches each level of structure.  A FieldRef does this once,
+ * then gives constant time access to the same field of any Value with the same type.
+ * eg. the Values from cloneEmpty() of a prototype, or updates of one subscription.
+ *
+ * @code
+ * auto proto(nt::NTScalar{TypeCode::Int32}.create());
+ * const FieldRef value(proto, "value"), sec(proto, "timeStamp.secondsPastEpoch");
+ * ...
+ * auto update(proto.cloneEmpty());
+ * update[value] = 42;
+ * update[sec] = 1234;
+ * @endcode
+ *
+ * May only refer to fields within nested Structs.  Not through a Union, Any,
+ * or array of Struct, which are separately allocated.
+ */
+class PVXS_API FieldRef {
+    friend class Value;
+    // type of the Struct resolved against
+    std::shared_ptr<const impl::FieldDesc> base;
+    // field index relative to base
+    size_t offset;
+    // original name, used with other types
+    std::string expr;
+public:
+    //! Empty reference.  Gives an invalid Value.
+    FieldRef() :offset(0u) {}
+    /** Resolve the named field of proto.
+     *
+     * @throws NoField if proto has no such field.
+     * @throws std::logic_error if the name passes through a Union, Any, or array of Struct.
+     */
+    FieldRef(const Value& proto, const std::string& name);
+
+    //! The name given when resolved
+    inline const std::string& name() const { return expr; }
+};
+
+/** Column-wise storage for many instances of one Struct type.
+ *
+ * Each leaf field of the prototype becomes a column of contiguous storage.
+ * eg. a vector of double for a Float64 field, or one character buffer for a String field.
+ * The marked flags of each appended Value are kept as a row of a bit matrix.
+ * Meant for scans over many updates of one type.  eg. monitor history.
+ *
+ * @code
+ * ValueBatch batch(proto);
+ * ...
+ * batch.append(update); // update.compareType(proto)
+ * ...
+ * auto col = batch.find("value");
+ * shared_array<const double> values(batch.column<double>(col));
+ * for(auto row : batch) {
+ *     if(row.isMarked(col))
+ *         process(row.as<double>(col));
+ * }
+ * @endcode
+ *
+ * Copies of a ValueBatch reference the same storage.
+ */
+class PVXS_API ValueBatch {
+    struct Pvt;
+    std::shared_ptr<Pvt> pvt;
+public:
+    class Row;
+    class iterator;
+
+    //! Empty batch with no columns.  append() will throw.
+    ValueBatch() = default;
+    /** Prepare columns for the type of proto, which must be a Struct.
+     * @throws std::logic_error if proto is not a Struct
+     */
+    explicit ValueBatch(const Value& proto);
+    ~ValueBatch();
+
+    //! Number of rows (appended Values)
+    size_t size() const;
+    inline bool empty() const { return size()==0u; }
+    //! Number of columns (leaf fields)
+    size_t ncolumns() const;
+    /** Column of a leaf field name.  eg. "timeStamp.nanoseconds"
+     * @throws NoField if no such leaf field
+     */
+    size_t find(const std::string& name) const;
+    //! Name of column
+    const std::string& name(size_t col) const;
+    //! Storage type of column
+    StoreType storageType(size_t col) const;
+
+    //! Allocate storage for at least this many rows
+    void reserve(size_t nrows);
+    /** Add a row with the values and marked flags of val.
+     * @throws std::logic_error unless val.compareType() with the prototype
+     */
+    void append(const Value& val);
+    //! Remove all rows
+    void clear();
+
+    /** Copy of all rows of one column.  eg. shared_array<const double> for a Float64 field.
+     * Bool columns as shared_array<const bool>, String as shared_array<const std::string>,
+     * and Union/Any/Struct[] as shared_array<const Value>.
+     * @throws std::logic_error for a column of arrays
+     */
+    shared_array<const void> column(size_t col) const;
+    //! column() converted to element type E
+    template<typename E>
+    inline shared_array<const E> column(size_t col) const {
+        return column(col).template convertTo<const E>();
+    }
+
+    //! True if the field was marked, either itself or through an enclosing Struct.
+    bool isMarked(size_t row, size_t col) const;
+    //! New Value with the fields, and marked flags, of one row
+    Value value(size_t row) const;
+
+    // use with caution
+    void copyOut(size_t row, size_t col, void *ptr, StoreType type) const;
+
+    inline Row operator[](size_t row) const;
+    inline iterator begin() const;
+    inline iterator end() const;
+};
+
+//! View of one row of a ValueBatch.  Valid while the ValueBatch exists.
+class ValueBatch::Row {
+    const ValueBatch* batch;
+    size_t row;
+    friend class ValueBatch;
+    friend class ValueBatch::iterator;
+    constexpr Row(const ValueBatch* batch, size_t row) :batch(batch), row(row) {}
+public:
+    //! Position in the batch
+    inline size_t index() const { return row; }
+    inline bool isMarked(size_t col) const { return batch->isMarked(row, col); }
+    //! Extract from column, as with Value::as<T>()
+    template<typename T>
+    inline T as(size_t col) const {
+        typename impl::StoreAs<T>::store_t ret;
+        batch->copyOut(row, col, &ret, impl::StoreAs<T>::code);
+        return impl::StoreTransform<T>::out(ret);
+    }
+    //! cf. ValueBatch::value()
+    inline Value value() const { return batch->value(row); }
+};
+
+class ValueBatch::iterator {
+    Row cur;
+    friend class ValueBatch;
+    constexpr iterator(const ValueBatch* batch, size_t row) :cur(batch, row) {}
+public:
+    iterator() :cur(nullptr, 0u) {}
+    const Row& operator*() const { return cur; }
+    const Row* operator->() const { return &cur; }
+    iterator& operator++() { cur.row++; return *this; }
+    iterator operator++(int) { iterator ret(*this); cur.row++; return ret; }
+    bool operator==(const iterator& o) const { return cur.row == o.cur.row; }
+    bool operator!=(const iterator& o) const { return !(o==*this); }
+};
+
+ValueBatch::Row ValueBatch::operator[](size_t row) const { return Row{this, row}; }
+ValueBatch::iterator ValueBatch::begin() const { return iterator{this, 0u}; }
+ValueBatch::iterator ValueBatch::end() const { return iterator{this, size()}; }
+
+namespace impl {
+template<typename T, typename M>
+struct MappedMember {
+    const char* name;
+    M T::* mptr;
+};
+} // namespace impl
+
+//! Associate a field name with a data member.  cf. StructMap
+template<typename T, typename M>
+constexpr impl::MappedMember<T, M> mapMember(const char* name, M T::* mptr)
+{
+    return impl::MappedMember<T, M>{name, mptr};
+}
+
+/** Mapping between the data members of a plain C++ struct and fields of a Struct type.
+ *
+ * The member types are fixed at compile time.  Field names are resolved, as with FieldRef,
+ * once when the StructMap is created.  encode() and decode() then access each field
+ * by position, without name lookups or temporary Values for scalar and string fields.
+ *
+ * @code
+ * struct Reading {
+ *     double value;
+ *     int32_t severity;
+ *     std::string message;
+ * };
+ * static const auto rmap(makeStructMap(nt::NTScalar{TypeCode::Float64, true}.create(),
+ *                                      mapMember("value", &Reading::value),
+ *                                      mapMember("alarm.severity", &Reading::severity),
+ *                                      mapMember("alarm.message", &Reading::message)));
+ * ...
+ * Value update(rmap.encode(Reading{1.0, 0, ""})); // mapped fields are marked
+ * Reading r(rmap.decode(update));
+ * @endcode
+ */
+template<typename T, typename... M>
+class StructMap {
+    static_assert(sizeof...(M)>0u, "StructMap requires at least one member");
+
+    Value proto;
+    std::tuple<impl::MappedMember<T, M>...> members;
+    FieldRef refs[sizeof...(M)];
+
+    template<size_t I>
+    using member_t = typename std::tuple_element<I, std::tuple<M...>>::type;
+
+    template<size_t I>
+    typename std::enable_if<I==sizeof...(M)>::type
+    _resolve() {}
+    template<size_t I>
+    typename std::enable_if<(I<sizeof...(M))>::type
+    _resolve() {
+        refs[I] = FieldRef(proto, std::get<I>(members).name);
+        _resolve<I+1u>();
+    }
+
+    template<size_t I>
+    typename std::enable_if<I==sizeof...(M)>::type
+    _encode(Value&, const T&) const {}
+    template<size_t I>
+    typename std::enable_if<(I<sizeof...(M))>::type
+    _encode(Value& dst, const T& src) const {
+        typedef member_t<I> mem_t;
+        const typename impl::StoreAs<mem_t>::store_t& norm(impl::StoreTransform<mem_t>::in(src.*(std::get<I>(members).mptr)));
+        dst.copyIn(refs[I], &norm, impl::StoreAs<mem_t>::code);
+        _encode<I+1u>(dst, src);
+    }
+
+    template<size_t I>
+    typename std::enable_if<I==sizeof...(M)>::type
+    _decode(T&, const Value&) const {}
+    template<size_t I>
+    typename std::enable_if<(I<sizeof...(M))>::type
+    _decode(T& dst, const Value& src) const {
+        typedef member_t<I> mem_t;
+        typename impl::StoreAs<mem_t>::store_t temp;
+        src.copyOut(refs[I], &temp, impl::StoreAs<mem_t>::code);
+        dst.*(std::get<I>(members).mptr) = impl::StoreTransform<mem_t>::out(temp);
+        _decode<I+1u>(dst, src);
+    }
+
+public:
+    /** Resolve member names against proto.
+     * @throws NoField if proto has no such field.
+     */
+    explicit StructMap(const Value& proto, const impl::MappedMember<T, M>&... mem)
+        :proto(proto.cloneEmpty())
+        ,members(mem...)
+    {
+        _resolve<0u>();
+    }
+
+    //! An empty Value of the mapped type
+    inline Value create() const { return proto.cloneEmpty(); }
+
+    /** Assign, and mark, the mapped fields of dst.
+     * dst should have the type of the prototype.  Other types are handled by name.
+     */
+    inline void encode(Value& dst, const T& src) const { _encode<0u>(dst, src); }
+    //! New Value from create() with the mapped fields assigned and marked
+    inline Value encode(const T& src) const {
+        Value ret(proto.cloneEmpty());
+        _encode<0u>(ret, src);
+        return ret;
+    }
+
+    //! Extract the mapped fields of src into dst
+    inline void decode(T& dst, const Value& src) const { _decode<0u>(dst, src); }
+    //! Extract the mapped fields of src into a value initialized T
+    inline T decode(const Value& src) const {
+        T ret{};
+        _decode<0u>(ret, src);
+        return ret;
+    }
+};
+
+//! Construct a StructMap, deducing its type from the mapMember() arguments
+template<typename T, typename... M>
+StructMap<T, M...> makeStructMap(const Value& proto, const impl::MappedMember<T, M>&... mem)
+{
+    return StructMap<T, M...>(proto, mem...);
+}
+
 PVXS_API
 std::ostream& operator<<(std::ostream& strm, const Value::Fmt& fmt);
 
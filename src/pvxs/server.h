@@ -127,6 +127,44 @@ struct PVXS_API Config {
     unsigned short udp_port = 5076;
     //! Whether to populate the beacon address list automatically.  (recommended)
     bool auto_beacon = true;
+    /** Number of worker threads which handle TCP connections.
+     *  Each connection, and all operations on it, stay with one worker.
+     *  New connections are assigned to workers in turn.
+     *  With 1 (the default), connections are handled by the thread which accepts them.
+     *  Zero selects the number of CPU cores.
+     *
+     *  More than one worker is opt-in.  Callbacks for different connections,
+     *  eg. Source::onCreate() and operation callbacks,
+     *  may then run concurrently, and must be thread safe.
+     *  A Source written for a single worker may not be.
+     *  SharedPV serializes its onFirstConnect() and onLastDisconnect() callbacks.
+     *  Its onPut() and onRPC() callbacks may run concurrently.
+     */
+    unsigned workers = 1u;
+    /** Number of TCP listening sockets opened on each interface.
+     *  With more than one, the sockets share a port through SO_REUSEPORT,
+     *  and the OS spreads incoming connections among them.
+     *  Each listener is owned by a worker, which then handles the connections
+     *  it accepts.  So workers is raised to at least this number.
+     *  Ignored (treated as 1) where SO_REUSEPORT is not available.
+     */
+    unsigned tcp_listeners = 1u;
+    //! TCP listen() backlog.  Zero selects a platform default.
+    unsigned listen_backlog = 0u;
+    /** Stop reading requests from a client while more than this many bytes
+     *  are waiting to be sent to it.  Must be non-zero.
+     */
+    size_t tcp_tx_high = 0x100000u;
+    //! Resume reading requests once the bytes waiting to be sent fall to this.  At most tcp_tx_high.
+    size_t tcp_tx_low = 0x80000u;
+    /** Max. number of waiting monitor updates sent to a client in one pass,
+     *  before waiting for its connection to become writable.
+     *  Lets other connections on the same worker run in between.
+     *  Zero for no limit.
+     */
+    size_t tcp_tx_drain = 0u;
+    //! Bytes of following messages which may be read along with the current message.  At least 8.
+    size_t tcp_readahead = 0x1000u;
 
     //! Server unique ID.  Only meaningful in readback via Server::config()
     std::array<uint8_t, 12> guid{};
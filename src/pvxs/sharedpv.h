@@ -51,6 +51,8 @@ struct PVXS_API SharedPV
     void attach(std::unique_ptr<ChannelControl>&& op);
 
     //! Callback when the number of attach()d clients becomes non-zero.
+    //! Calls to onFirstConnect and onLastDisconnect are serialized, and alternate,
+    //! even when clients are handled by several server workers.
     void onFirstConnect(std::function<void()>&& fn);
     //! Callback when the number of attach()d clients becomes zero.
     void onLastDisconnect(std::function<void()>&& fn);
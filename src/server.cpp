@@ -34,6 +34,8 @@ namespace pvxs {
 namespace server {
 using namespace impl;
 
+typedef epicsGuard<epicsMutex> Guard;
+
 DEFINE_LOGGER(serversetup, "pvxs.server.setup");
 DEFINE_LOGGER(serverio, "pvxs.server.io");
 
@@ -231,6 +233,13 @@ Server::Pvt::Pvt(const Config &conf)
 {
     effective.expand();
 
+    if(effective.workers>1u) {
+        workers.reserve(effective.workers);
+        for(auto i : range(effective.workers)) {
+            workers.emplace_back(new evbase(SB()<<"PVXTCP-"<<i, epicsThreadPriorityCAServerLow-2));
+        }
+    }
+
     {
         int val = 1;
         if(setsockopt(beaconSender.sock, SOL_SOCKET, SO_BROADCAST, (char *)&val, sizeof(val)))
@@ -255,7 +264,16 @@ Server::Pvt::Pvt(const Config &conf)
 
         bool firstiface = true;
         for(const auto& addr : effective.interfaces) {
-            interfaces.emplace_back(addr, effective.tcp_port, this, firstiface);
+            if(effective.tcp_listeners<=1u) {
+                interfaces.emplace_back(addr, effective.tcp_port, this, acceptor_loop, firstiface, false);
+
+            } else {
+                auto port = ServIface::probePort(addr, effective.tcp_port, firstiface);
+
+                for(auto i : range(effective.tcp_listeners)) {
+                    interfaces.emplace_back(addr, port, this, *workers[i%workers.size()], false, true);
+                }
+            }
             if(firstiface || effective.tcp_port==0)
                 effective.tcp_port = interfaces.back().bind_addr.port();
             firstiface = false;
@@ -348,9 +366,11 @@ void Server::Pvt::start()
         log_debug_printf(serversetup, "Server starting\n%s", "");
 
         for(auto& iface : interfaces) {
-            if(evconnlistener_enable(iface.listener.get())) {
-                log_err_printf(serversetup, "Error enabling listener on %s\n", iface.name.c_str());
-            }
+            iface.loop.call([&iface]() {
+                if(evconnlistener_enable(iface.listener.get())) {
+                    log_err_printf(serversetup, "Error enabling listener on %s\n", iface.name.c_str());
+                }
+            });
             log_debug_printf(serversetup, "Server enabled listener on %s\n", iface.name.c_str());
         }
     });
@@ -406,23 +426,51 @@ void Server::Pvt::stop()
     {
         // stop accepting new TCP connections
         for(auto& iface : interfaces) {
-            if(evconnlistener_disable(iface.listener.get())) {
-                log_err_printf(serversetup, "Error disabling listener on %s\n", iface.name.c_str());
-            }
+            iface.loop.call([&iface]() {
+                if(evconnlistener_disable(iface.listener.get())) {
+                    log_err_printf(serversetup, "Error disabling listener on %s\n", iface.name.c_str());
+                }
+            });
             log_debug_printf(serversetup, "Server disabled listener on %s\n", iface.name.c_str());
         }
 
-        // close current TCP connections
-        auto conns = std::move(connections);
-        for(auto& pair : conns) {
-            pair.second->bev.reset();
-            pair.second->cleanup();
-        }
+    });
+
+    // flush any connections still being setup by workers
+    for(auto& worker : workers)
+        worker->sync();
 
+    // close current TCP connections
+    decltype(connections) conns;
+    {
+        Guard G(connectionsLock);
+        conns = std::move(connections);
+    }
+    for(auto& pair : conns) {
+        auto& conn = pair.second;
+        conn->loop.call([&conn]() {
+            conn->bev.reset();
+            conn->cleanup();
+            conn.reset();
+        });
+    }
+
+    acceptor_loop.call([this]()
+    {
         state = Stopped;
     });
 }
 
+evbase& Server::Pvt::pickLoop()
+{
+    if(workers.empty())
+        return acceptor_loop;
+
+    auto& ret = *workers[nextWorker];
+    nextWorker = (nextWorker+1u)%workers.size();
+    return ret;
+}
+
 void Server::Pvt::onSearch(const UDPManager::Search& msg)
 {
     // on UDPManager worker
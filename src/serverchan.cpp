@@ -34,6 +34,7 @@ ServerChan::~ServerChan() {}
 
 ServerChannelControl::ServerChannelControl(const std::shared_ptr<ServerConn> &conn, const std::shared_ptr<ServerChan>& channel)
     :server(conn->iface->server->internal_self)
+    ,loop(conn->loop)
     ,chan(channel)
 {
     _op = None;
@@ -50,7 +51,7 @@ void ServerChannelControl::onOp(std::function<void(std::unique_ptr<server::Conne
     if(!serv)
         return;
 
-    serv->acceptor_loop.call([this, &fn](){
+    loop.call([this, &fn](){
         auto ch = chan.lock();
         if(!ch)
             return;
@@ -65,7 +66,7 @@ void ServerChannelControl::onRPC(std::function<void(std::unique_ptr<server::Exec
     if(!serv)
         return;
 
-    serv->acceptor_loop.call([this, &fn](){
+    loop.call([this, &fn](){
         auto ch = chan.lock();
         if(!ch)
             return;
@@ -80,7 +81,7 @@ void ServerChannelControl::onSubscribe(std::function<void(std::unique_ptr<server
     if(!serv)
         return;
 
-    serv->acceptor_loop.call([this, &fn](){
+    loop.call([this, &fn](){
         auto ch = chan.lock();
         if(!ch)
             return;
@@ -95,7 +96,7 @@ void ServerChannelControl::onClose(std::function<void(const std::string&)>&& fn)
     if(!serv)
         return;
 
-    serv->acceptor_loop.call([this, &fn](){
+    loop.call([this, &fn](){
         auto ch = chan.lock();
         if(!ch)
             return;
@@ -147,7 +148,7 @@ void ServerChannelControl::close()
     if(!serv)
         return;
 
-    serv->acceptor_loop.call([this](){
+    loop.call([this](){
         auto ch = chan.lock();
         if(!ch)
             return;
@@ -156,11 +157,12 @@ void ServerChannelControl::close()
             if(ch->state==ServerChan::Active) {
                 // Send unsolicited Channel Destroy
 
-                auto tx = bufferevent_get_output(conn->bev.get());
-                EvOutBuf R(hostBE, tx);
-                to_wire(R, Header{CMD_DESTROY_CHANNEL, pva_flags::Server, 8});
-                to_wire(R, ch->sid);
-                to_wire(R, ch->cid);
+                {
+                    EvOutBuf R(hostBE, conn->txBody.get());
+                    to_wire(R, ch->sid);
+                    to_wire(R, ch->cid);
+                }
+                conn->enqueueTxBody(CMD_DESTROY_CHANNEL);
 
                 ServerChannel_shutdown(ch);
             }
@@ -174,7 +176,7 @@ std::pair<std::string, Value> ServerChannelControl::rawCredentials() const
     std::pair<std::string, Value> ret;
     auto serv = server.lock();
     if(serv)
-        serv->acceptor_loop.call([this, &ret](){
+        loop.call([this, &ret](){
             if(auto chan = this->chan.lock())
                 if(auto conn = chan->conn.lock())
                     ret = std::make_pair(conn->autoMethod, conn->credentials.clone());
@@ -390,13 +392,17 @@ void ServerConn::handle_DESTROY_CHANNEL()
     // ServerChannel is delete'd
 
     {
-        auto tx = bufferevent_get_output(bev.get());
-        EvOutBuf R(hostBE, tx);
-        to_wire(R, Header{CMD_DESTROY_CHANNEL, pva_flags::Server, 8});
-        to_wire(R, sid);
-        to_wire(R, cid);
+        bool ok;
+        {
+            EvOutBuf R(hostBE, txBody.get());
+            to_wire(R, sid);
+            to_wire(R, cid);
+            ok = R.good();
+        }
 
-        if(!R.good())
+        if(ok)
+            enqueueTxBody(CMD_DESTROY_CHANNEL);
+        else
             bev.reset();
     }
 }
@@ -15,11 +15,10 @@
 #include <pvxs/log.h>
 #include "serverconn.h"
 
-// limit on size of TX buffer above which we suspend RX
-static constexpr size_t tcp_tx_limit = 0x100000;
-
 namespace pvxs {namespace impl {
 
+typedef epicsGuard<epicsMutex> Guard;
+
 // message related to client state and errors
 DEFINE_LOGGER(connsetup, "pvxs.tcp.setup");
 // related to low level send/recv
@@ -27,11 +26,16 @@ DEFINE_LOGGER(connio, "pvxs.tcp.io");
 
 DEFINE_LOGGER(remote, "pvxs.remote.log");
 
-ServerConn::ServerConn(ServIface* iface, evutil_socket_t sock, struct sockaddr *peer, int socklen)
+ServerConn::ServerConn(ServIface* iface, evbase& loop, evutil_socket_t sock, const SockAddr& peer)
     :ConnBase(false,
-              bufferevent_socket_new(iface->server->acceptor_loop.base, sock, BEV_OPT_CLOSE_ON_FREE|BEV_OPT_DEFER_CALLBACKS),
-              SockAddr(peer, socklen))
+              bufferevent_socket_new(loop.base, sock, BEV_OPT_CLOSE_ON_FREE|BEV_OPT_DEFER_CALLBACKS),
+              peer,
+              iface->server->effective.tcp_readahead)
     ,iface(iface)
+    ,loop(loop)
+    ,txHigh(iface->server->effective.tcp_tx_high)
+    ,txLow(iface->server->effective.tcp_tx_low)
+    ,txDrain(iface->server->effective.tcp_tx_drain)
 {
     log_debug_printf(connio, "Client %s connects\n", peerName.c_str());
 
@@ -86,18 +90,77 @@ const std::shared_ptr<ServerChan>& ServerConn::lookupSID(uint32_t sid)
     return it->second;
 }
 
-void ServerConn::handle_ECHO()
+void ServerConn::markReady(const std::shared_ptr<ServerOp>& op)
 {
-    // Client requests echo as a keep-alive check
+    bool wake;
+    {
+        Guard G(readyLock);
+        if(op->readyQueued)
+            return;
+        op->readyQueued = true;
 
-    auto tx = bufferevent_get_output(bev.get());
-    uint32_t len = evbuffer_get_length(segBuf.get());
+        auto tail = readyTail;
+        readyTail = op.get();
+        if(tail)
+            tail->readyNext = op;
+        else
+            readyHead = op;
+
+        wake = !readyWake;
+        readyWake = true;
+    }
+
+    if(wake) {
+        // one wakeup for however many ops become ready before sendReady() runs
+        auto self(shared_from_this());
+        loop.dispatch([self]() {
+            self->sendReady();
+        });
+    }
+}
+
+void ServerConn::sendReady()
+{
+    size_t nsent = 0u;
+    while(bev) {
+        if(txPending()>=txHigh || (txDrain && nsent>=txDrain && txPending())) {
+            // give other connections on this worker a turn.
+            // continue from bevWrite() when some of what we have queued is sent.
+            if(txPending()<txHigh)
+                limitsHit.txDrain++;
+            bufferevent_setwatermark(bev.get(), EV_WRITE, txLow, 0);
+            break;
+        }
+
+        std::shared_ptr<ServerOp> op;
+        {
+            Guard G(readyLock);
+            if(!readyHead) {
+                readyWake = false;
+                break;
+            }
+            op = std::move(readyHead);
+            readyHead = std::move(op->readyNext);
+            if(!readyHead)
+                readyTail = nullptr;
+            op->readyQueued = false;
+        }
 
-    to_evbuf(tx, Header{CMD_ECHO, pva_flags::Server, len}, hostBE);
+        // may markReady() again, to the back of the line
+        op->replyReady();
+        nsent++;
+    }
+}
 
-    auto err = evbuffer_add_buffer(tx, segBuf.get());
+void ServerConn::handle_ECHO()
+{
+    // Client requests echo as a keep-alive check
+
+    auto err = evbuffer_add_buffer(txBody.get(), segBuf.get());
     assert(!err);
 
+    enqueueTxBody(CMD_ECHO);
+
     // maybe help reduce latency
     bufferevent_flush(bev.get(), EV_WRITE, BEV_FLUSH);
 }
@@ -279,11 +342,19 @@ void ServerConn::cleanup()
 {
     log_debug_printf(connsetup, "Client %s Cleanup TCP Connection\n", peerName.c_str());
 
-    auto it = iface->server->connections.find(this);
-    if(it!=iface->server->connections.end()) {
-        auto self = std::move(it->second);
-        iface->server->connections.erase(it);
+    std::shared_ptr<ServerConn> self;
+    {
+        auto server = iface->server;
+        Guard G(server->connectionsLock);
 
+        auto it = server->connections.find(this);
+        if(it!=server->connections.end()) {
+            self = std::move(it->second);
+            server->connections.erase(it);
+        }
+    }
+
+    if(self) {
         for(auto& pair : self->opByIOID) {
             if(pair.second->onClose)
                 pair.second->onClose("");
@@ -303,12 +374,12 @@ void ServerConn::bevRead()
 
     if(!bev) {
 
-    } else if(auto tx = bufferevent_get_output(bev.get())) {
-        if(evbuffer_get_length(tx)>=tcp_tx_limit) {
+    } else {
+        if(txPending()>=txHigh) {
             // write buffer "full".  stop reading until it drains
-            // TODO configure
+            limitsHit.txHigh++;
             (void)bufferevent_disable(bev.get(), EV_READ);
-            bufferevent_setwatermark(bev.get(), EV_WRITE, tcp_tx_limit/2, 0);
+            bufferevent_setwatermark(bev.get(), EV_WRITE, txLow, 0);
             log_debug_printf(connio, "%s suspend READ\n", peerName.c_str());
         }
     }
@@ -318,58 +389,92 @@ void ServerConn::bevWrite()
 {
     log_debug_printf(connio, "%s process backlog\n", peerName.c_str());
 
-    auto tx = bufferevent_get_output(bev.get());
-    // handle pending monitors
+    // continue any long message
+    pumpTx();
 
-    while(!backlog.empty() && evbuffer_get_length(tx)<tcp_tx_limit) {
-        auto fn = std::move(backlog.front());
-        backlog.pop_front();
-
-        fn();
-    }
+    // handle pending monitors
+    sendReady();
 
-    // TODO configure
-    if(evbuffer_get_length(tx)<tcp_tx_limit) {
+    if(bev && txPending()<txHigh) {
+        bool waiting;
+        {
+            Guard G(readyLock);
+            waiting = readyWake;
+        }
         (void)bufferevent_enable(bev.get(), EV_READ);
-        bufferevent_setwatermark(bev.get(), EV_WRITE, 0, 0);
+        bufferevent_setwatermark(bev.get(), EV_WRITE, waiting ? txLow : 0u, 0);
         log_debug_printf(connio, "%s resume READ\n", peerName.c_str());
     }
 }
 
 
-ServIface::ServIface(const std::string& addr, unsigned short port, server::Server::Pvt *server, bool fallback)
+ServIface::ServIface(const std::string& addr, unsigned short port, server::Server::Pvt *server, evbase& loop, bool fallback, bool reuse)
     :server(server)
+    ,loop(loop)
     ,bind_addr(AF_INET, addr.c_str(), port)
     ,sock(AF_INET, SOCK_STREAM, 0)
 {
     server->acceptor_loop.assertInLoop();
 
+#ifdef SO_REUSEPORT
+    if(reuse) {
+        int val = 1;
+        if(setsockopt(sock.sock, SOL_SOCKET, SO_REUSEPORT, (char *)&val, sizeof(val)))
+            log_err_printf(connsetup, "Unable to set SO_REUSEPORT on %s : %d\n", addr.c_str(), SOCKERRNO);
+    }
+#else
+    (void)reuse;
+#endif
+
+    bindPort(sock, bind_addr, fallback);
+
+    name = bind_addr.tostring();
+
+    // added in libevent 2.1.1
+#ifndef LEV_OPT_DISABLED
+#  define LEV_OPT_DISABLED 0
+#endif
+
+    // libevent treats zero as "already listening", and negative as "pick a default"
+    const int backlog = server->effective.listen_backlog ? int(server->effective.listen_backlog) : -1;
+
+    // the listener belongs to its worker
+    loop.call([this, backlog]() {
+        listener = evlisten(evconnlistener_new(this->loop.base, onConnS, this, LEV_OPT_DISABLED, backlog, sock.sock));
+
+        if(!LEV_OPT_DISABLED)
+            evconnlistener_disable(listener.get());
+    });
+}
+
+void ServIface::bindPort(const evsocket& sock, SockAddr& addr, bool fallback)
+{
     // try to bind to requested port, then fallback to a random port
     while(true) {
         try {
-            sock.bind(bind_addr);
+            sock.bind(addr);
         } catch(std::system_error& e) {
             if(fallback && e.code().value()==SOCK_EADDRINUSE) {
-                bind_addr.setPort(0);
+                addr.setPort(0);
                 continue;
             }
             throw;
         }
         break;
     }
+}
 
-    name = bind_addr.tostring();
-
-    // added in libevent 2.1.1
-#ifndef LEV_OPT_DISABLED
-#  define LEV_OPT_DISABLED 0
-#endif
-
-    const int backlog = 4;
-    listener = evlisten(evconnlistener_new(server->acceptor_loop.base, onConnS, this, LEV_OPT_DISABLED, backlog, sock.sock));
-
-    if(!LEV_OPT_DISABLED)
-        evconnlistener_disable(listener.get());
+unsigned short ServIface::probePort(const std::string& addr, unsigned short port, bool fallback)
+{
+    // SO_REUSEPORT would let us bind a port already used by another process with SO_REUSEPORT,
+    // and then silently share its connections.  So first check that the port is free with an
+    // exclusive bind.  This socket can not be kept open, as it would also exclude our own
+    // SO_REUSEPORT listeners.  So it is closed on return, and another process could still
+    // bind, with SO_REUSEPORT, in the window before the first of our listeners.
+    evsocket probe(AF_INET, SOCK_STREAM, 0);
+    SockAddr probe_addr(AF_INET, addr.c_str(), port);
+    bindPort(probe, probe_addr, fallback);
+    return probe_addr.port();
 }
 
 void ServIface::onConnS(struct evconnlistener *listener, evutil_socket_t sock, struct sockaddr *peer, int socklen, void *raw)
@@ -381,14 +486,36 @@ void ServIface::onConnS(struct evconnlistener *listener, evutil_socket_t sock, s
             evutil_closesocket(sock);
             return;
         }
-        auto conn(std::make_shared<ServerConn>(self, sock, peer, socklen));
-        self->server->connections[conn.get()] = std::move(conn);
+        // connections accepted by a worker stay with it
+        auto& loop = &self->loop==&self->server->acceptor_loop ? self->server->pickLoop() : self->loop;
+        if(loop.inLoop()) {
+            addConn(self, loop, sock, SockAddr(peer, socklen));
+
+        } else {
+            SockAddr addr(peer, socklen);
+            loop.dispatch([self, &loop, sock, addr]() {
+                // on connection worker
+                try {
+                    addConn(self, loop, sock, addr);
+                }catch(std::exception& e){
+                    log_exc_printf(connsetup, "Interface %s Unhandled error in connection setup: %s\n", self->name.c_str(), e.what());
+                    evutil_closesocket(sock);
+                }
+            });
+        }
     }catch(std::exception& e){
         log_exc_printf(connsetup, "Interface %s Unhandled error in accept callback: %s\n", self->name.c_str(), e.what());
         evutil_closesocket(sock);
     }
 }
 
+void ServIface::addConn(ServIface* self, evbase& loop, evutil_socket_t sock, const SockAddr& peer)
+{
+    auto conn(std::make_shared<ServerConn>(self, loop, sock, peer));
+    Guard G(self->server->connectionsLock);
+    self->server->connections[conn.get()] = std::move(conn);
+}
+
 ServerOp::~ServerOp() {}
 
 }} // namespace pvxs::impl
@@ -13,6 +13,7 @@
 #include <atomic>
 
 #include <epicsEvent.h>
+#include <epicsMutex.h>
 
 #include <pvxs/server.h>
 #include <pvxs/source.h>
@@ -47,12 +48,47 @@ struct ServerOp
         Dead,
     } state;
 
+    // link in ServerConn ready list.  Guarded by ServerConn::readyLock
+    std::shared_ptr<ServerOp> readyNext;
+    bool readyQueued = false;
+
     ServerOp(const std::weak_ptr<ServerChan>& chan, uint32_t ioid) :chan(chan), ioid(ioid), state(Idle) {}
     ServerOp(const ServerOp&) = delete;
     ServerOp& operator=(const ServerOp&) = delete;
     virtual ~ServerOp() =0;
+
+    // from worker.  Send (at most) one queued reply.  cf. ServerConn::markReady()
+    virtual void replyReady() {}
+};
+
+/* One update posted to many subscribers.  cf. SharedPV::post()
+ *
+ * 'val' is not modified after construction.  Serialized payloads are cached by pvMask,
+ * and are shared by reference between all subscribers with the same pvMask.
+ * (copied with libevent < 2.1)
+ */
+struct MonitorFanout
+{
+    // frozen
+    const Value val;
+
+    explicit MonitorFanout(Value&& val) :val(std::move(val.freeze())) {}
+    MonitorFanout(const MonitorFanout&) = delete;
+    MonitorFanout& operator=(const MonitorFanout&) = delete;
+
+    // append BitMask and partial value
+    void encode(evbuffer* dest, const BitMask& pvMask);
+
+private:
+    epicsMutex lock;
+    std::vector<std::pair<BitMask, evbuf>> encoded;
+
+    INST_COUNTER(MonitorFanout);
 };
 
+// post() which shares serialization with other subscribers when possible.
+bool postFanout(server::MonitorControlOp& ctrl, const std::shared_ptr<MonitorFanout>& update);
+
 struct ServerChannelControl : public server::ChannelControl
 {
     ServerChannelControl(const std::shared_ptr<ServerConn>& conn, const std::shared_ptr<ServerChan>& chan);
@@ -68,6 +104,8 @@ struct ServerChannelControl : public server::ChannelControl
     virtual std::pair<std::string, Value> rawCredentials() const override final;
 
     const std::weak_ptr<server::Server::Pvt> server;
+    // only use while server.lock() succeeds
+    evbase& loop;
     const std::weak_ptr<ServerChan> chan;
 
     INST_COUNTER(ServerChannelControl);
@@ -104,6 +142,10 @@ struct ServerChan
 struct ServerConn : public ConnBase, public std::enable_shared_from_this<ServerConn>
 {
     ServIface* const iface;
+    // worker which handles this connection, and all of its operations.  cf. Server::Pvt::pickLoop()
+    evbase& loop;
+    // TX flow control.  cf. Config::tcp_tx_high, tcp_tx_low, and tcp_tx_drain
+    const size_t txHigh, txLow, txDrain;
 
     std::string autoMethod;
     Value credentials;
@@ -112,17 +154,26 @@ struct ServerConn : public ConnBase, public std::enable_shared_from_this<ServerC
     std::map<uint32_t, std::shared_ptr<ServerChan> > chanBySID;
     std::map<uint32_t, std::shared_ptr<ServerOp> > opByIOID;
 
-    std::list<std::function<void()>> backlog;
+    // Intrusive list of operations with replies waiting to be sent.
+    // Appended from any thread by markReady(), drained by the worker in sendReady().
+    epicsMutex readyLock;
+    std::shared_ptr<ServerOp> readyHead;
+    ServerOp* readyTail = nullptr;
+    // set while the list is non-empty, and sendReady() is dispatched or waiting for bevWrite()
+    bool readyWake = false;
 
     INST_COUNTER(ServerConn);
 
-    ServerConn(ServIface* iface, evutil_socket_t sock, struct sockaddr *peer, int socklen);
+    ServerConn(ServIface* iface, evbase& loop, evutil_socket_t sock, const SockAddr& peer);
     ServerConn(const ServerConn&) = delete;
     ServerConn& operator=(const ServerConn&) = delete;
     ~ServerConn();
 
     const std::shared_ptr<ServerChan>& lookupSID(uint32_t sid);
 
+    // from any thread.  Arrange for op->replyReady() to be called from the worker.
+    void markReady(const std::shared_ptr<ServerOp>& op);
+
 private:
 #define CASE(Op) virtual void handle_##Op() override final;
     CASE(ECHO);
@@ -154,11 +205,14 @@ private:
     //void bevEvent(short events);
     virtual void bevRead() override final;
     virtual void bevWrite() override final;
+    void sendReady();
 };
 
 struct ServIface
 {
     server::Server::Pvt * const server;
+    // worker which owns listener.  When acceptor_loop, accepted connections are passed to Server::Pvt::pickLoop()
+    evbase& loop;
 
     SockAddr bind_addr;
     std::string name;
@@ -166,9 +220,17 @@ struct ServIface
     evsocket sock;
     evlisten listener;
 
-    ServIface(const std::string& addr, unsigned short port, server::Server::Pvt *server, bool fallback);
+    // with reuse, several ServIface may bind the same address.  cf. Config::tcp_listeners
+    ServIface(const std::string& addr, unsigned short port, server::Server::Pvt *server, evbase& loop, bool fallback, bool reuse);
+
+    // bind to the requested port.  If fallback, then try a random port if it is in use.
+    static void bindPort(const evsocket& sock, SockAddr& addr, bool fallback);
+    // find a port, not in use when probed, to which ServIface(..., reuse=true) may bind.
+    static unsigned short probePort(const std::string& addr, unsigned short port, bool fallback);
 
     static void onConnS(struct evconnlistener *listener, evutil_socket_t sock, struct sockaddr *peer, int socklen, void *raw);
+    // on the selected worker, create and register a new ServerConn
+    static void addConn(ServIface* self, evbase& loop, evutil_socket_t sock, const SockAddr& peer);
 };
 
 
@@ -213,11 +275,18 @@ struct Server::Pvt
     // handle server "background" tasks.
     // accept new connections and send beacons
     evbase acceptor_loop;
+    // handle TCP connections when Config::workers>1.  Otherwise empty, and acceptor_loop is used.
+    std::vector<std::unique_ptr<evbase>> workers;
+    // only access from acceptor_loop
+    size_t nextWorker = 0u;
 
     std::list<std::unique_ptr<UDPListener> > listeners;
     std::vector<SockAddr> beaconDest;
 
     std::list<ServIface> interfaces;
+
+    // guards connections, which are added from acceptor_loop and removed from workers
+    epicsMutex connectionsLock;
     std::map<ServerConn*, std::shared_ptr<ServerConn> > connections;
 
     evsocket beaconSender;
@@ -247,6 +316,9 @@ struct Server::Pvt
     void start();
     void stop();
 
+    // from acceptor_loop, select the worker for a new connection
+    evbase& pickLoop();
+
 private:
     void onSearch(const UDPManager::Search& msg);
     void doBeacons(short evt);
@@ -67,7 +67,16 @@ struct ServerGPR : public ServerOp
         {
             (void)evbuffer_drain(conn->txBody.get(), evbuffer_get_length(conn->txBody.get()));
 
-            EvOutBuf R(hostBE, conn->txBody.get());
+            // reserve space for the whole reply at once
+            size_t hint = 16u;
+            if(sts.isSuccess() && state==Executing && value) {
+                if(cmd==CMD_GET || (cmd==CMD_PUT && (subcmd&0x40)))
+                    hint += encoded_size_valid(value, &pvMask);
+                else if(cmd==CMD_RPC)
+                    hint += encoded_size_full(value);
+            }
+
+            EvOutBuf R(hostBE, conn->txBody.get(), std::min(hint, tcp_tx_segment));
             to_wire(R, uint32_t(ioid));
             to_wire(R, subcmd);
             to_wire(R, sts);
@@ -83,7 +92,7 @@ struct ServerGPR : public ServerOp
             } else if(state==Creating) {
                 // connect()
                 if(cmd!=CMD_RPC) {
-                    to_wire(R, type.get());
+                    to_wire(R, type, conn->txRegistry);
                 }
                 state = Idle;
 
@@ -92,8 +101,7 @@ struct ServerGPR : public ServerOp
                     to_wire_valid(R, value, &pvMask); // GET and PUT/Get reply with bitmask and partial value
 
                 } else if(cmd==CMD_RPC) {
-                    auto type = Value::Helper::desc(value);
-                    to_wire(R, type);
+                    to_wire(R, Value::Helper::type(value), conn->txRegistry);
                     if(value)
                         to_wire_full(R, value);
                 }
@@ -115,7 +123,7 @@ struct ServerGPR : public ServerOp
                 conn->opByIOID.erase(it);
 
                 if(self->onClose)
-                    conn->iface->server->acceptor_loop.dispatch([self](){
+                    conn->loop.dispatch([self](){
                         self->onClose("");
                     });
 
@@ -149,6 +157,7 @@ struct ServerGPRConnect : public server::ConnectOp
                      const Value& request,
                      const std::weak_ptr<ServerGPR>& op)
         :server(server)
+        ,loop(conn->loop)
         ,op(op)
     {
         _op = Info;
@@ -166,7 +175,7 @@ struct ServerGPRConnect : public server::ConnectOp
         auto serv = server.lock();
         if(!serv)
             return;
-        serv->acceptor_loop.call([this, &prototype](){
+        loop.call([this, &prototype](){
             if(auto oper = op.lock()) {
                 if(oper->state!=ServerOp::Creating)
                     return;
@@ -193,7 +202,7 @@ struct ServerGPRConnect : public server::ConnectOp
         auto serv = server.lock();
         if(!serv)
             return;
-        serv->acceptor_loop.call([this, &msg](){
+        loop.call([this, &msg](){
             if(auto oper = op.lock()) {
                 if(oper->state==ServerOp::Creating)
                     oper->doReply(Value(), msg);
@@ -206,7 +215,7 @@ struct ServerGPRConnect : public server::ConnectOp
         auto serv = server.lock();
         if(!serv)
             return;
-        serv->acceptor_loop.call([this, &fn](){
+        loop.call([this, &fn](){
             if(auto oper = op.lock())
                 oper->onGet = std::move(fn);
         });
@@ -216,7 +225,7 @@ struct ServerGPRConnect : public server::ConnectOp
         auto serv = server.lock();
         if(!serv)
             return;
-        serv->acceptor_loop.call([this, &fn](){
+        loop.call([this, &fn](){
             if(auto oper = op.lock())
                 oper->onPut = std::move(fn);
         });
@@ -226,7 +235,7 @@ struct ServerGPRConnect : public server::ConnectOp
         auto serv = server.lock();
         if(!serv)
             return;
-        serv->acceptor_loop.call([this, &fn](){
+        loop.call([this, &fn](){
             if(auto oper = op.lock())
                 oper->onClose = std::move(fn);
         });
@@ -237,7 +246,7 @@ struct ServerGPRConnect : public server::ConnectOp
         std::pair<std::string, Value> ret;
         auto serv = server.lock();
         if(serv)
-            serv->acceptor_loop.call([this, &ret](){
+            loop.call([this, &ret](){
                 if(auto oper = op.lock())
                     if(auto chan = oper->chan.lock())
                         if(auto conn = chan->conn.lock())
@@ -247,6 +256,7 @@ struct ServerGPRConnect : public server::ConnectOp
     }
 
     const std::weak_ptr<server::Server::Pvt> server;
+    evbase& loop;
     const std::weak_ptr<ServerGPR> op;
 
     INST_COUNTER(ServerGPRConnect);
@@ -260,6 +270,7 @@ struct ServerGPRExec : public server::ExecOp
                      const Value& request,
                      const std::weak_ptr<ServerGPR>& op)
         :server(server)
+        ,loop(conn->loop)
         ,op(op)
     {
         _op = Info;
@@ -279,7 +290,7 @@ struct ServerGPRExec : public server::ExecOp
         auto serv = server.lock();
         if(!serv)
             return;
-        serv->acceptor_loop.call([this, &val](){
+        loop.call([this, &val](){
             if(auto oper = op.lock()) {
                 oper->doReply(val, std::string());
             }
@@ -293,7 +304,7 @@ struct ServerGPRExec : public server::ExecOp
         auto serv = server.lock();
         if(!serv)
             return;
-        serv->acceptor_loop.call([this, &msg](){
+        loop.call([this, &msg](){
             if(auto oper = op.lock()) {
                 oper->doReply(Value(), msg);
             }
@@ -305,7 +316,7 @@ struct ServerGPRExec : public server::ExecOp
         auto serv = server.lock();
         if(!serv)
             return;
-        serv->acceptor_loop.call([this, &fn](){
+        loop.call([this, &fn](){
             if(auto oper = op.lock())
                 oper->onCancel = std::move(fn);
         });
@@ -316,7 +327,7 @@ struct ServerGPRExec : public server::ExecOp
         std::pair<std::string, Value> ret;
         auto serv = server.lock();
         if(serv)
-            serv->acceptor_loop.call([this, &ret](){
+            loop.call([this, &ret](){
                 if(auto oper = op.lock())
                     if(auto chan = oper->chan.lock())
                         if(auto conn = chan->conn.lock())
@@ -326,6 +337,7 @@ struct ServerGPRExec : public server::ExecOp
     }
 
     const std::weak_ptr<server::Server::Pvt> server;
+    evbase& loop;
     const std::weak_ptr<ServerGPR> op;
 
     INST_COUNTER(ServerGPRExec);
@@ -21,7 +21,7 @@ struct ServerIntrospect : public ServerOp
     {}
     virtual ~ServerIntrospect() {}
 
-    void doReply(const FieldDesc* type, const Status& sts)
+    void doReply(const std::shared_ptr<const FieldDesc>& type, const Status& sts)
     {
         if(state != ServerOp::Executing)
             return;
@@ -39,7 +39,7 @@ struct ServerIntrospect : public ServerOp
             to_wire(R, uint32_t(ioid));
             to_wire(R, sts);
             if(type)
-                to_wire(R, type);
+                to_wire(R, type, conn->txRegistry);
         }
 
         conn->enqueueTxBody(CMD_GET_FIELD);
@@ -58,6 +58,7 @@ struct ServerIntrospectControl : public server::ConnectOp
                             const std::weak_ptr<server::Server::Pvt>& server,
                             const std::weak_ptr<ServerIntrospect>& op)
         :server(server)
+        ,loop(conn->loop)
         ,op(op)
     {
         _op = Info;
@@ -71,7 +72,7 @@ struct ServerIntrospectControl : public server::ConnectOp
 
     virtual void connect(const Value& prototype) override final
     {
-        auto desc = Value::Helper::desc(prototype);
+        auto desc = Value::Helper::type(prototype);
         if(!desc)
             throw std::logic_error("Can't reply to GET_FIELD with Null prototype");
         Status sts{Status::Ok};
@@ -84,13 +85,13 @@ struct ServerIntrospectControl : public server::ConnectOp
         doReply(nullptr, sts);
     }
 
-    void doReply(const FieldDesc* type, const Status& sts)
+    void doReply(const std::shared_ptr<const FieldDesc>& type, const Status& sts)
     {
         auto serv = server.lock();
         if(!serv)
             return; // soft fail if already completed, cancelled, disconnected, ....
 
-        serv->acceptor_loop.call([this, type, &sts](){
+        loop.call([this, type, &sts](){
             if(auto oper = op.lock())
                 oper->doReply(type, sts);
         });
@@ -101,7 +102,7 @@ struct ServerIntrospectControl : public server::ConnectOp
         auto serv = server.lock();
         if(!serv)
             return;
-        serv->acceptor_loop.call([this, &fn](){
+        loop.call([this, &fn](){
             if(auto oper = op.lock())
                 oper->onClose = std::move(fn);
         });
@@ -112,7 +113,7 @@ struct ServerIntrospectControl : public server::ConnectOp
         std::pair<std::string, Value> ret;
         auto serv = server.lock();
         if(serv)
-            serv->acceptor_loop.call([this, &ret](){
+            loop.call([this, &ret](){
                 if(auto oper = op.lock())
                     if(auto chan = oper->chan.lock())
                         if(auto conn = chan->conn.lock())
@@ -126,6 +127,7 @@ struct ServerIntrospectControl : public server::ConnectOp
     virtual void onPut(std::function<void(std::unique_ptr<server::ExecOp>&& fn, Value&&)>&& fn) override final {}
 
     const std::weak_ptr<server::Server::Pvt> server;
+    evbase& loop;
     const std::weak_ptr<ServerIntrospect> op;
 
     INST_COUNTER(ServerIntrospectControl);
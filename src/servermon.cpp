@@ -6,6 +6,7 @@
 
 #include <cassert>
 
+#include <atomic>
 #include <deque>
 
 #include <epicsMutex.h>
@@ -15,6 +16,7 @@
 #include "dataimpl.h"
 #include "serverconn.h"
 #include "pvrequest.h"
+#include "spscring.h"
 
 namespace pvxs { namespace impl {
 DEFINE_LOGGER(connsetup, "pvxs.tcp.setup");
@@ -22,6 +24,10 @@ DEFINE_LOGGER(connio, "pvxs.tcp.io");
 
 namespace {
 
+// Upper bound on the per-subscription queue (and so ring) size requested by a client,
+// through record._options.queueSize or the pipeline window.
+constexpr size_t maxQueueSize = 0x10000u;
+
 typedef epicsGuard<epicsMutex> Guard;
 
 struct MonitorOp : public ServerOp,
@@ -32,7 +38,7 @@ struct MonitorOp : public ServerOp,
     {}
     virtual ~MonitorOp() {}
 
-    // only access from acceptor worker thread
+    // only access from connection worker thread
     std::function<void(bool)> onStart;
     std::function<void()> onLowMark;
     std::function<void()> onHighMark;
@@ -42,50 +48,92 @@ struct MonitorOp : public ServerOp,
     BitMask pvMask;
     std::string msg;
 
-    // Further members can only be changed from the accepter worker thread with this lock held.
+    // Further members, and state, can only be changed from the connection worker thread with this lock held.
     // They may be read from the worker, or if this lock is held.
+    // post()ing threads do not use this lock.
     mutable epicsMutex lock;
 
-    // is doReply() scheduled to run
-    bool scheduled=false;
     bool pipeline=false;
     bool finished=false;
     size_t window=0u, limit=1u;
     size_t low=0u, high=0u;
 
-    std::deque<Value> queue;
+    // is doReply() scheduled to run
+    std::atomic<bool> scheduled{false};
+    // state==Executing && (!pipeline || window).  For post()ing threads.  cf. updateReady()
+    std::atomic<bool> ready{false};
+
+    struct Entry {
+        // empty to finish
+        Value val;
+        // when set, val is shared with other subscribers and may not be modified
+        std::shared_ptr<MonitorFanout> fanout;
+    };
+    // Filled by post()ing threads, emptied by doReply().
+    // Capacity limit+1 to always allow a finish() or forcePost() beyond limit.
+    SPSCRing<Entry> queue;
+    // serializes post()ing threads.  Also guards spill.
+    epicsMutex postLock;
+    // overflow of queue from repeated forcePost().  Used only when queue is full,
+    // and then until emptied by doReply().
+    std::deque<Entry> spill;
+    std::atomic<size_t> nspill{0u};
 
     INST_COUNTER(MonitorOp);
 
-    // caller must hold lock.
+    // number of queued updates
+    size_t pending() const {
+        return queue.size() + nspill.load();
+    }
+
+    // from worker, after changing state or window
+    void updateReady() {
+        ready.store(state==Executing && (!pipeline || window));
+    }
+
+    // Consumer.  Remove the oldest update
+    bool pop(Entry& ent) {
+        if(queue.pop(ent))
+            return true;
+        if(nspill.load()) {
+            Guard G(postLock);
+            if(queue.pop(ent))
+                return true; // raced with a post()
+            if(!spill.empty()) {
+                ent = std::move(spill.front());
+                spill.pop_front();
+                nspill--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // from any thread.  schedule doReply() if there is something which may be sent.
     // only used after State==Idle
     static
-    void maybeReply(server::Server::Pvt* server, const std::shared_ptr<MonitorOp>& op)
+    void maybeReply(const std::shared_ptr<MonitorOp>& op)
     {
         // can we send a reply?
-        if(!op->scheduled && op->state==Executing && !op->queue.empty() && (!op->pipeline || op->window))
+        if(op->ready.load() && op->pending() && !op->scheduled.exchange(true))
         {
             // based on operation state, yes
-            server->acceptor_loop.dispatch([op](){
-                auto ch(op->chan.lock());
-                if(!ch)
-                    return;
-                auto conn(ch->conn.lock());
-                if(!conn)
-                    return;
-
-                if(conn->bev && (bufferevent_get_enabled(conn->bev.get())&EV_READ)) {
-                    op->doReply();
-                } else {
-                    // connection TX queue is too full
-                    conn->backlog.push_back(std::bind(&MonitorOp::doReply, op));
-                }
-            });
-
-            op->scheduled = true;
+            auto ch(op->chan.lock());
+            if(!ch)
+                return;
+            auto conn(ch->conn.lock());
+            if(!conn)
+                return;
+
+            conn->markReady(op);
         }
     }
 
+    virtual void replyReady() override final
+    {
+        doReply();
+    }
+
     void doReply()
     {
         auto ch = chan.lock();
@@ -96,31 +144,40 @@ struct MonitorOp : public ServerOp,
             return;
 
         Guard G(lock);
-        scheduled = false;
+        // clear before pop(), so that a concurrent post() will reschedule
+        scheduled.store(false);
 
-        if(state==Dead)
+        if(state==Dead) {
+            ready.store(false);
             return;
+        }
 
         uint8_t subcmd = 0u;
+        Entry ent;
         if(state==Creating) {
             subcmd = 0x08;
             state = type ? Idle : Dead;
 
-        } else if(state==Executing) {
-            if(queue.empty() || (pipeline && !window)) {
-                return; // nothing to do
+        } else if((state==Executing && pipeline && !window) || !pop(ent)) {
+            return; // nothing to do
 
-            } else if(!queue.front()) {
-                finished = true;
-                subcmd = 0x10;
-                state = Dead;
-            }
+        } else if(state==Executing && !ent.val) {
+            finished = true;
+            subcmd = 0x10;
+            state = Dead;
         }
+        updateReady();
 
+        std::shared_ptr<MonitorFanout> fanout;
         {
             (void)evbuffer_drain(conn->txBody.get(), evbuffer_get_length(conn->txBody.get()));
 
-            EvOutBuf R(hostBE, conn->txBody.get());
+            // reserve space for the whole reply at once
+            size_t hint = 16u;
+            if(!(subcmd&0x08) && !ent.fanout && ent.val)
+                hint += encoded_size_valid(ent.val, &pvMask);
+
+            EvOutBuf R(hostBE, conn->txBody.get(), std::min(hint, tcp_tx_segment));
             to_wire(R, uint32_t(ioid));
             to_wire(R, subcmd);
             if(subcmd&0x08) {
@@ -129,24 +186,33 @@ struct MonitorOp : public ServerOp,
 
                 } else {
                     to_wire(R, Status{});
-                    to_wire(R, type.get());
+                    to_wire(R, type, conn->txRegistry);
                 }
 
-            } else if(!queue.empty()) {
-                auto& ent = queue.front();
-                if(ent) {
-                    to_wire_valid(R, ent, &pvMask);
+            } else {
+                if(ent.fanout) {
+                    // appended below
+                    fanout = std::move(ent.fanout);
+
+                } else if(ent.val) {
+                    to_wire_valid(R, ent.val, &pvMask);
                     // TODO: placeholder for overrun mask
                     to_wire(R, uint8_t(0u));
 
                 } else { // finish (could be used to send an error)
                     to_wire(R, Status{});
                 }
-
-                queue.pop_front();
             }
         }
 
+        if(fanout) {
+            fanout->encode(conn->txBody.get(), pvMask);
+
+            EvOutBuf R(hostBE, conn->txBody.get());
+            // TODO: placeholder for overrun mask
+            to_wire(R, uint8_t(0u));
+        }
+
         conn->enqueueTxBody(pva_app_msg_t::CMD_MONITOR);
 
         if(state == ServerOp::Dead) {
@@ -157,7 +223,7 @@ struct MonitorOp : public ServerOp,
                 conn->opByIOID.erase(it);
 
                 if(self->onClose)
-                    conn->iface->server->acceptor_loop.dispatch([self](){
+                    conn->loop.dispatch([self](){
                         self->onClose("");
                     });
 
@@ -175,24 +241,20 @@ struct MonitorOp : public ServerOp,
 
             bool before = window <= low;
             window--;
+            updateReady();
             bool after = window <= low;
 
             if(before && after && onLowMark) {
-                conn->iface->server->acceptor_loop.dispatch([self]() {
+                conn->loop.dispatch([self]() {
                     if(self->onLowMark)
                         self->onLowMark();
                 });
             }
         }
 
-        if(state==Executing && !queue.empty() && (!pipeline || window)) {
-            // reshedule myself
-            assert(!scheduled); // we've been holding the lock, so this should not have changed
-
-            conn->iface->server->acceptor_loop.dispatch([self]() {
-                self->doReply();
-            });
-            scheduled = true;
+        if(ready.load() && pending() && !scheduled.exchange(true)) {
+            // reshedule myself, after any other ready ops of this connection
+            conn->markReady(self);
         }
     }
 };
@@ -210,34 +272,74 @@ struct ServerMonitorControl : public server::MonitorControlOp
     }
 
     virtual bool doPost(Value&& val, bool maybe, bool force) override final
+    {
+        return doPost(MonitorOp::Entry{std::move(val), nullptr}, maybe, force);
+    }
+
+    bool doPost(MonitorOp::Entry&& ent, bool maybe, bool force)
     {
         auto mon(op.lock());
         if(!mon)
             return false;
 
-        Guard G(mon->lock);
+        auto& val = ent.val;
 
+        // type is const once we exist
         if(val && mon->type && mon->type.get()!=Value::Helper::desc(val))
             throw std::logic_error("Type change not allowed in post().  Recommend pvxs::Value::cloneEmpty()");
 
-        if((mon->queue.size() < mon->limit) || force || !val) {
-            mon->queue.push_back(std::move(val));
+        size_t npending;
+        {
+            Guard G(mon->postLock);
+            auto& Q = mon->queue;
+            bool always = force || !val;
 
-        } else if(!maybe) {
-            // squash
-            assert(mon->limit>0 && !mon->queue.empty());
+            if(!mon->nspill.load() && (always || Q.size() < mon->limit) && Q.push(ent)) {
+                // queued
 
-            mon->queue.back().assign(val);
-            // TODO track overrun
+            } else if(always) {
+                // queue full
+                mon->spill.push_back(std::move(ent));
+                mon->nspill++;
 
-        } else {
-            // nope
+            } else if(!maybe) {
+                // squash into the newest update, which we take back unless doReply() has already claimed it
+                MonitorOp::Entry last;
+                if(!mon->spill.empty()) {
+                    squash(mon->spill.back(), val);
+
+                } else if(Q.unpush(last)) {
+                    squash(last, val);
+                    Q.push(last);
+
+                } else {
+                    // queue emptied meanwhile
+                    Q.push(ent);
+                }
+
+            } else {
+                // nope
+            }
+
+            npending = mon->pending();
         }
 
         if(auto serv = server.lock())
-            MonitorOp::maybeReply(serv.get(), mon);
+            MonitorOp::maybeReply(mon);
 
-        return mon->queue.size() < mon->limit;
+        return npending < mon->limit;
+    }
+
+    static
+    void squash(MonitorOp::Entry& last, const Value& val)
+    {
+        if(last.val.isFrozen()) {
+            // shared, so make our own copy
+            last.val = last.val.thaw();
+            last.fanout.reset();
+        }
+        last.val.assign(val);
+        // TODO track overrun
     }
 
     virtual void stats(server::MonitorStat& stat) const override final
@@ -252,7 +354,7 @@ struct ServerMonitorControl : public server::MonitorControlOp
         stat.finished = mon->finished;
         stat.pipeline = mon->pipeline;
 
-        stat.nQueue = mon->queue.size();
+        stat.nQueue = mon->pending();
         stat.limitQueue = mon->limit;
         stat.window = mon->window;
     }
@@ -265,7 +367,7 @@ struct ServerMonitorControl : public server::MonitorControlOp
         auto serv = server.lock();
         if(!serv)
             return;
-        serv->acceptor_loop.call([this, low, high](){
+        loop.call([this, low, high](){
             if(auto oper = op.lock()) {
                 Guard G(oper->lock);
                 oper->low = low;
@@ -279,7 +381,7 @@ struct ServerMonitorControl : public server::MonitorControlOp
         auto serv = server.lock();
         if(!serv)
             return;
-        serv->acceptor_loop.call([this, &fn](){
+        loop.call([this, &fn](){
             if(auto oper = op.lock())
                 oper->onStart = std::move(fn);
         });
@@ -289,7 +391,7 @@ struct ServerMonitorControl : public server::MonitorControlOp
         auto serv = server.lock();
         if(!serv)
             return;
-        serv->acceptor_loop.call([this, &fn](){
+        loop.call([this, &fn](){
             if(auto oper = op.lock())
                 oper->onHighMark = std::move(fn);
         });
@@ -299,7 +401,7 @@ struct ServerMonitorControl : public server::MonitorControlOp
         auto serv = server.lock();
         if(!serv)
             return;
-        serv->acceptor_loop.call([this, &fn](){
+        loop.call([this, &fn](){
             if(auto oper = op.lock())
                 oper->onLowMark = std::move(fn);
         });
@@ -310,7 +412,7 @@ struct ServerMonitorControl : public server::MonitorControlOp
         std::pair<std::string, Value> ret;
         auto serv = server.lock();
         if(serv)
-            serv->acceptor_loop.call([this, &ret](){
+            loop.call([this, &ret](){
                 if(auto oper = op.lock())
                     if(auto chan = oper->chan.lock())
                         if(auto conn = chan->conn.lock())
@@ -320,6 +422,7 @@ struct ServerMonitorControl : public server::MonitorControlOp
     }
 
     const std::weak_ptr<server::Server::Pvt> server;
+    evbase& loop;
     const std::weak_ptr<MonitorOp> op;
 
     INST_COUNTER(ServerMonitorControl);
@@ -333,6 +436,7 @@ struct ServerMonitorSetup : public server::MonitorSetupOp
                      const Value& request,
                      const std::weak_ptr<MonitorOp>& op)
         :server(server)
+        ,loop(conn->loop)
         ,op(op)
     {
         _op = Info;
@@ -357,7 +461,7 @@ struct ServerMonitorSetup : public server::MonitorSetupOp
         auto serv = server.lock();
         if(!serv)
             return ret;
-        serv->acceptor_loop.call([this, &type, &ret, &mask](){
+        loop.call([this, &type, &ret, &mask](){
             if(auto oper = op.lock()) {
                 if(oper->state!=ServerOp::Creating)
                     return;
@@ -379,7 +483,7 @@ struct ServerMonitorSetup : public server::MonitorSetupOp
         auto serv = server.lock();
         if(!serv)
             return;
-        serv->acceptor_loop.call([this, &msg](){
+        loop.call([this, &msg](){
             if(auto oper = op.lock()) {
                 if(oper->state==ServerOp::Creating) {
                     oper->msg = msg;
@@ -393,7 +497,7 @@ struct ServerMonitorSetup : public server::MonitorSetupOp
         auto serv = server.lock();
         if(!serv)
             return;
-        serv->acceptor_loop.call([this, &fn](){
+        loop.call([this, &fn](){
             if(auto oper = op.lock())
                 oper->onClose = std::move(fn);
         });
@@ -404,7 +508,7 @@ struct ServerMonitorSetup : public server::MonitorSetupOp
         std::pair<std::string, Value> ret;
         auto serv = server.lock();
         if(serv)
-            serv->acceptor_loop.call([this, &ret](){
+            loop.call([this, &ret](){
                 if(auto oper = op.lock())
                     if(auto chan = oper->chan.lock())
                         if(auto conn = chan->conn.lock())
@@ -414,6 +518,7 @@ struct ServerMonitorSetup : public server::MonitorSetupOp
     }
 
     const std::weak_ptr<server::Server::Pvt> server;
+    evbase& loop;
     const std::weak_ptr<MonitorOp> op;
 
     INST_COUNTER(ServerMonitorSetup);
@@ -425,6 +530,7 @@ ServerMonitorControl::ServerMonitorControl(ServerMonitorSetup* setup,
                                            const std::string& name,
                                            const std::weak_ptr<MonitorOp>& op)
     :server(server)
+    ,loop(setup->loop)
     ,op(op)
 {
     _op = Info;
@@ -435,6 +541,62 @@ ServerMonitorControl::ServerMonitorControl(ServerMonitorSetup* setup,
 
 } // namespace
 
+void MonitorFanout::encode(evbuffer* dest, const BitMask& pvMask)
+{
+    Guard G(lock);
+
+    evbuffer* payload = nullptr;
+    for(auto& pair : encoded) {
+        if(pair.first==pvMask) {
+            payload = pair.second.get();
+            break;
+        }
+    }
+
+    if(!payload) {
+        evbuf temp(evbuffer_new());
+#if LIBEVENT_VERSION_NUMBER >= 0x02010000
+        // Referenced from the TX buffers of connections on different workers,
+        // which adjust reference counts of temp and its chains as they drain.
+        if(!temp || evbuffer_enable_locking(temp.get(), nullptr))
+            throw std::bad_alloc();
+#endif
+        {
+            EvOutBuf R(hostBE, temp.get(), std::min(encoded_size_valid(val, &pvMask), tcp_tx_segment));
+            to_wire_valid(R, val, &pvMask);
+            if(!R.good())
+                throw std::bad_alloc();
+        }
+        BitMask key(pvMask.size()); // not copyable
+        for(auto i : range(pvMask.wsize()))
+            key.word(i) = pvMask.word(i);
+
+        encoded.emplace_back(std::move(key), std::move(temp));
+        payload = encoded.back().second.get();
+    }
+
+#if LIBEVENT_VERSION_NUMBER >= 0x02010000
+    if(evbuffer_add_buffer_reference(dest, payload))
+        throw std::bad_alloc();
+#else
+    // no references between evbuffers, so copy
+    auto len = evbuffer_get_length(payload);
+    auto raw = evbuffer_pullup(payload, -1);
+    if(len && (!raw || evbuffer_add(dest, raw, len)))
+        throw std::bad_alloc();
+#endif
+}
+
+bool postFanout(server::MonitorControlOp& ctrl, const std::shared_ptr<MonitorFanout>& update)
+{
+    if(auto mon = dynamic_cast<ServerMonitorControl*>(&ctrl)) {
+        return mon->doPost(MonitorOp::Entry{update->val, update}, false, false);
+
+    } else {
+        return ctrl.post(update->val.clone());
+    }
+}
+
 void ServerConn::handle_MONITOR()
 {
     EvInBuf M(peerBE, segBuf.get(), 16);
@@ -483,6 +645,14 @@ void ServerConn::handle_MONITOR()
         if(op->limit < op->window)
             op->limit = op->window;
 
+        if(op->limit > maxQueueSize) {
+            log_debug_printf(connsetup, "Client %s Monitor ioid=%u queue %zu limited to %zu\n",
+                             peerName.c_str(), unsigned(ioid), op->limit, maxQueueSize);
+            op->limit = maxQueueSize;
+        }
+
+        op->queue.reset(op->limit+1u);
+
         std::unique_ptr<ServerMonitorSetup> ctrl(new ServerMonitorSetup(this, iface->server->internal_self, chan->name, pvRequest, op));
 
         op->state = ServerOp::Creating;
@@ -547,11 +717,12 @@ void ServerConn::handle_MONITOR()
             bool before = op->window > op->high;
 
             op->window += nack;
+            op->updateReady();
 
             bool after = op->window > op->high;
 
             if(!before && after && op->onHighMark) {
-                iface->server->acceptor_loop.dispatch([op](){
+                loop.dispatch([op](){
                     if(op->onHighMark)
                         op->onHighMark();
                 });
@@ -567,15 +738,16 @@ void ServerConn::handle_MONITOR()
             {
                 Guard G(op->lock);
                 op->state = start ? ServerOp::Executing : ServerOp::Idle;
+                op->updateReady();
             }
 
             if(op->onStart)
                 op->onStart(start);
+        }
 
-            {
-                Guard G(op->lock);
-                MonitorOp::maybeReply(iface->server, op);
-            }
+        if(subcmd&0x84) {
+            // start, or ack, may allow a reply
+            MonitorOp::maybeReply(op);
         }
 
         if(subcmd&0x10) {
@@ -588,7 +760,7 @@ void ServerConn::handle_MONITOR()
                 opByIOID.erase(it);
 
                 if(self->onClose) {
-                    iface->server->acceptor_loop.dispatch([self](){
+                    loop.dispatch([self](){
                         if(self->onClose)
                             self->onClose("");
                     });
@@ -18,6 +18,7 @@
 
 #include "utilpvt.h"
 #include "dataimpl.h"
+#include "serverconn.h"
 
 typedef epicsGuard<epicsMutex> Guard;
 typedef epicsGuardRelease<epicsMutex> UnGuard;
@@ -33,6 +34,10 @@ using ptr_set = std::set<T, std::owner_less<T>>;
 struct SharedPV::Impl : public std::enable_shared_from_this<Impl>
 {
     mutable epicsMutex lock;
+    // Serializes changes to channels with the onFirstConnect and onLastDisconnect
+    // callbacks they trigger, which are made without lock.  With several server workers,
+    // channels may attach and close concurrently.  Always locked before lock.
+    epicsMutex connLock;
 
     std::function<void(SharedPV&, std::unique_ptr<ExecOp>&&, Value&&)> onPut;
     std::function<void(SharedPV&, std::unique_ptr<ExecOp>&&, Value&&)> onRPC;
@@ -46,6 +51,15 @@ struct SharedPV::Impl : public std::enable_shared_from_this<Impl>
     std::set<std::shared_ptr<MonitorControlOp>> subscribers;
 
     Value current;
+    // frozen copy of current, shared by GET replies and new subscribers
+    // until the next post().  Built on demand.
+    std::shared_ptr<impl::MonitorFanout> snapshot;
+
+    const std::shared_ptr<impl::MonitorFanout>& snap() {
+        if(!snapshot)
+            snapshot = std::make_shared<impl::MonitorFanout>(current.clone());
+        return snapshot;
+    }
 
     INST_COUNTER(SharedPVImpl);
 };
@@ -141,7 +155,7 @@ void SharedPV::attach(std::unique_ptr<ChannelControl>&& ctrlop)
             {
                 Guard G(self->lock);
                 if(self->current)
-                    got = self->current.clone();
+                    got = self->snap()->val;
             }
             if(got) {
                 op->reply(got);
@@ -178,6 +192,7 @@ void SharedPV::attach(std::unique_ptr<ChannelControl>&& ctrlop)
 
             log_debug_printf(logshared, "%s on %s OP onClose\n", conn->peerName().c_str(), conn->name().c_str());
 
+            Guard G(self->lock);
             self->pending.erase(conn);
         });
 
@@ -224,7 +239,7 @@ void SharedPV::attach(std::unique_ptr<ChannelControl>&& ctrlop)
                 self->subscribers.erase(sub);
             });
 
-            sub->post(self->current.clone());
+            impl::postFanout(*sub, self->snap());
             self->subscribers.emplace(std::move(sub));
         }
     });
@@ -234,6 +249,7 @@ void SharedPV::attach(std::unique_ptr<ChannelControl>&& ctrlop)
 
         log_debug_printf(logshared, "%s on %s Chan close\n", ctrl->peerName().c_str(), ctrl->name().c_str());
 
+        Guard C(self->connLock);
         Guard G(self->lock);
 
         self->channels.erase(ctrl);
@@ -248,6 +264,7 @@ void SharedPV::attach(std::unique_ptr<ChannelControl>&& ctrlop)
         }
     });
 
+    Guard C(self->connLock);
     Guard G(self->lock);
 
     bool first = impl->channels.empty();
@@ -316,6 +333,7 @@ void SharedPV::open(const Value& initial)
         mpending = std::move(impl->mpending);
 
         impl->current = initial.clone();
+        impl->snapshot.reset();
     }
 
     // TODO the following is really inefficient if we aren't on a worker.
@@ -342,7 +360,7 @@ void SharedPV::open(const Value& initial)
 
         //c++17 adds std::set::merge()
         for(auto& sub : subscribers) {
-            sub->post(impl->current.clone());
+            impl::postFanout(*sub, impl->snap());
             impl->subscribers.insert(sub);
         }
     }
@@ -370,6 +388,7 @@ void SharedPV::close()
             return; // ignore double close()
 
         impl->current = Value();
+        impl->snapshot.reset();
 
         impl->subscribers.clear();
         channels = std::move(impl->channels);
@@ -396,9 +415,16 @@ void SharedPV::post(Value&& val)
         throw std::logic_error("post() requires the exact type of open().  Recommend pvxs::Value::cloneEmpty()");
 
     impl->current.assign(val);
+    impl->snapshot.reset();
+
+    if(impl->subscribers.empty())
+        return;
+
+    // one copy, and one serialization per pvMask, shared by all subscribers
+    auto update(std::make_shared<impl::MonitorFanout>(val.clone()));
 
     for(auto& sub : impl->subscribers) {
-        sub->post(val.clone());
+        impl::postFanout(*sub, update);
     }
 }
 
@@ -0,0 +1,134 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvxs is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+#ifndef PVXS_SPSCRING_H
+#define PVXS_SPSCRING_H
+
+#include <atomic>
+#include <vector>
+#include <stdexcept>
+#include <cstddef>
+
+namespace pvxs {
+namespace impl {
+
+/** Bounded FIFO between one producer thread and one consumer thread.
+ *
+ *  Neither side blocks, or waits for, the other.
+ *  push() and pop() are a load and a store of free running indices,
+ *  except when pop() takes the only entry.
+ *
+ *  The producer may also unpush() its newest entry, unless the consumer has claimed it,
+ *  then modify it and push() it again.  This allows an update to be merged ("squashed")
+ *  into the newest entry.  The consumer claims (advances head) before it moves an entry out,
+ *  so unpush() and pop() race only for the last entry.
+ *
+ *  With several producers, the caller must serialize them.
+ */
+template<typename T>
+class SPSCRing {
+    // power of two, larger than capacity, so that the slot being moved out by pop()
+    // is never the slot being written by push()
+    std::vector<T> slots;
+    size_t mask = 0u;
+    size_t cap = 0u;
+    // free running.  head only changed by the consumer, tail only by the producer.
+    // pop() may briefly move head past tail while racing unpush().
+    std::atomic<size_t> head{0u}, tail{0u};
+
+    static inline size_t used(size_t H, size_t T_) {
+        auto n = ptrdiff_t(T_ - H);
+        return n > 0 ? size_t(n) : 0u;
+    }
+
+public:
+    explicit SPSCRing(size_t capacity=0u) { reset(capacity); }
+    SPSCRing(const SPSCRing&) = delete;
+    SPSCRing& operator=(const SPSCRing&) = delete;
+
+    //! Discard all entries and change capacity.  Not concurrent with any other method.
+    //! Allocates all slots.  Throws std::length_error if capacity can not be represented.
+    void reset(size_t capacity) {
+        if(capacity >= (~size_t(0u))>>1u)
+            throw std::length_error("SPSCRing capacity too large");
+        size_t nslots = 1u;
+        while(nslots <= capacity)
+            nslots <<= 1u;
+        slots.clear();
+        slots.resize(nslots);
+        mask = nslots-1u;
+        cap = capacity;
+        head.store(0u);
+        tail.store(0u);
+    }
+
+    inline size_t capacity() const { return cap; }
+
+    //! Number of entries.  Exact when called by the producer or consumer while the other is idle.
+    inline size_t size() const {
+        auto H = head.load(std::memory_order_acquire);
+        return used(H, tail.load(std::memory_order_acquire));
+    }
+    inline bool empty() const { return size()==0u; }
+
+    //! Producer.  Append val, moving from it.  Returns false (val unchanged) if full.
+    bool push(T& val) {
+        auto T_ = tail.load(std::memory_order_relaxed);
+        if(used(head.load(std::memory_order_acquire), T_) >= cap)
+            return false;
+
+        slots[T_&mask] = std::move(val);
+        tail.store(T_+1u, std::memory_order_release);
+        return true;
+    }
+    bool push(T&& val) { return push(val); }
+
+    //! Producer.  Remove and return the newest entry, unless the consumer claims it first.
+    bool unpush(T& val) {
+        auto T_ = tail.load(std::memory_order_relaxed);
+        if(used(head.load(std::memory_order_acquire), T_)==0u)
+            return false;
+
+        // Retract, then check that pop() has not claimed.  pop() does the reverse.
+        // With sequential consistency, at least one of us sees the other.
+        tail.store(T_-1u, std::memory_order_seq_cst);
+        if(head.load(std::memory_order_seq_cst) == T_) {
+            tail.store(T_, std::memory_order_seq_cst);
+            return false;
+        }
+
+        val = std::move(slots[(T_-1u)&mask]);
+        return true;
+    }
+
+    //! Consumer.  Remove and return the oldest entry.  Returns false if empty.
+    bool pop(T& val) {
+        auto H = head.load(std::memory_order_relaxed);
+        auto T_ = tail.load(std::memory_order_acquire);
+        if(H == T_)
+            return false;
+
+        if(T_ - H == 1u) {
+            // may race with unpush() of this entry
+            head.store(H+1u, std::memory_order_seq_cst);
+            if(tail.load(std::memory_order_seq_cst) == H) {
+                head.store(H, std::memory_order_seq_cst);
+                return false;
+            }
+        } else {
+            head.store(H+1u, std::memory_order_release);
+        }
+
+        // claimed.  push() will not write this slot until after our next pop()
+        auto& slot = slots[H&mask];
+        val = std::move(slot);
+        slot = T();
+        return true;
+    }
+};
+
+}} // namespace pvxs::impl
+
+#endif // PVXS_SPSCRING_H
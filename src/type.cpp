@@ -5,13 +5,23 @@
  */
 
 #include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <functional>
+#include <unordered_map>
+
 #include <epicsAssert.h>
+#include <epicsMutex.h>
+#include <epicsGuard.h>
+#include <epicsThread.h>
 
 #include "dataimpl.h"
 #include "utilpvt.h"
 
 namespace pvxs {
 
+typedef epicsGuard<epicsMutex> Guard;
+
 struct Member::Helper {
     static
     void node_validate(const Member* parent, const std::string& id, TypeCode code);
@@ -215,19 +225,24 @@ void Member::Helper::build_tree(std::vector<FieldDesc>& desc, const Member& node
         if(code.code==TypeCode::Struct)
             child.parent_index = cindex-cref;
 
-        fld.mlookup[cnode.name] = cindex-cref;
+        fld.mlookup.insert(cnode.name, cindex-cref);
         fld.miter.emplace_back(cnode.name, cindex-cref);
 
         std::string cname = cnode.name+".";
         if(fld.code.code==TypeCode::Struct && fld.code==child.code) {
             // propagate names from sub-struct
             for(auto& cpair : child.mlookup) {
-                fld.mlookup[cname+cpair.first] = cindex-cref+cpair.second;
+                fld.mlookup.insert(cname, cpair.first, cindex-cref+cpair.second);
             }
         }
     }
 
+    desc[index].mlookup.sort();
+
     assert(desc.size()==index+desc[index].size());
+
+    if(code.code==TypeCode::Struct)
+        build_plan(&desc[index]);
 }
 
 TypeDef::TypeDef(std::shared_ptr<const Member>&& temp)
@@ -378,6 +393,168 @@ std::ostream& operator<<(std::ostream& strm, const TypeDef& def)
 
 namespace impl {
 
+void NameTable::insert(const std::string& name, size_t index)
+{
+    insert(std::string(), NameRef{name.data(), name.size()}, index);
+}
+
+void NameTable::insert(const std::string& prefix, const NameRef& name, size_t index)
+{
+    auto len = prefix.size() + name.len;
+    if(arena.size() + len > std::numeric_limits<uint32_t>::max())
+        throw std::length_error("Field names too long");
+
+    Entry ent{uint32_t(arena.size()), uint32_t(len), index};
+    arena += prefix;
+    arena.append(name.ptr, name.len);
+    entries.push_back(ent);
+}
+
+void NameTable::sort()
+{
+    auto& ar = arena;
+    auto less = [&ar](const Entry& lhs, const Entry& rhs) -> bool {
+        auto n = std::min(lhs.length, rhs.length);
+        int ret = n ? memcmp(ar.data()+lhs.offset, ar.data()+rhs.offset, n) : 0;
+        return ret<0 || (ret==0 && lhs.length < rhs.length);
+    };
+
+    // stable, so that the last of any duplicates wins (as with map[name] = index)
+    std::stable_sort(entries.begin(), entries.end(), less);
+
+    size_t out = 0u;
+    for(size_t i=0u; i<entries.size(); i++) {
+        if(i+1u < entries.size() && !less(entries[i], entries[i+1u]))
+            continue; // superceded by a later insert()
+        entries[out++] = entries[i];
+    }
+    entries.resize(out);
+
+    entries.shrink_to_fit();
+    arena.shrink_to_fit();
+}
+
+namespace {
+
+struct type_gbl_t {
+    epicsMutex lock;
+    // structural hash -> type
+    std::unordered_multimap<size_t, std::weak_ptr<const FieldDesc>> types;
+    // sweep expired entries when types.size() reaches this
+    size_t pruneAt = 64u;
+} *type_gbl;
+
+epicsThreadOnceId type_once = EPICS_THREAD_ONCE_INIT;
+
+void type_init(void *unused)
+{
+    (void)unused;
+    type_gbl = new type_gbl_t;
+}
+
+inline
+void hash_combine(size_t& seed, size_t val)
+{
+    seed ^= val + 0x9e3779b9 + (seed<<6) + (seed>>2);
+}
+
+// hash 'count' consecutive nodes.  plan and mlookup are derived from miter, so are not included
+size_t hash_descs(const FieldDesc* desc, size_t count)
+{
+    std::hash<std::string> shash;
+    size_t ret = count;
+    for(auto i : range(count)) {
+        auto& fld = desc[i];
+        hash_combine(ret, fld.code.code);
+        hash_combine(ret, shash(fld.id));
+        for(auto& pair : fld.miter) {
+            hash_combine(ret, shash(pair.first));
+            hash_combine(ret, pair.second);
+        }
+        if(!fld.members.empty())
+            hash_combine(ret, hash_descs(fld.members.data(), fld.members.size()));
+    }
+    return ret;
+}
+
+bool same_descs(const FieldDesc* lhs, const FieldDesc* rhs, size_t count)
+{
+    for(auto i : range(count)) {
+        auto& L = lhs[i];
+        auto& R = rhs[i];
+        if(L.code!=R.code || L.parent_index!=R.parent_index || L.id!=R.id
+                || L.miter!=R.miter || L.members.size()!=R.members.size()
+                || !same_descs(L.members.data(), R.members.data(), L.members.size()))
+            return false;
+    }
+    return true;
+}
+
+} // namespace
+
+std::shared_ptr<const FieldDesc> intern_type(const std::shared_ptr<const FieldDesc>& desc)
+{
+    if(!desc)
+        return desc;
+
+    epicsThreadOnce(&type_once, &type_init, nullptr);
+    assert(type_gbl);
+
+    const auto count = desc->size();
+    const auto key = hash_descs(desc.get(), count);
+
+    std::shared_ptr<const FieldDesc> ret;
+    {
+        Guard G(type_gbl->lock);
+
+        auto range = type_gbl->types.equal_range(key);
+        for(auto it = range.first; it!=range.second;) {
+            auto other(it->second.lock());
+            if(!other) {
+                it = type_gbl->types.erase(it);
+
+            } else if(other->size()==count && same_descs(other.get(), desc.get(), count)) {
+                ret = std::move(other);
+                break;
+
+            } else {
+                ++it;
+            }
+        }
+
+        if(!ret) {
+            if(type_gbl->types.size() >= type_gbl->pruneAt) {
+                for(auto it = type_gbl->types.begin(); it!=type_gbl->types.end();) {
+                    if(it->second.expired())
+                        it = type_gbl->types.erase(it);
+                    else
+                        ++it;
+                }
+                type_gbl->pruneAt = std::max(size_t(64u), 2u*type_gbl->types.size());
+            }
+
+            type_gbl->types.emplace(key, desc);
+            ret = desc;
+        }
+    }
+    return ret;
+}
+
+size_t intern_type_count()
+{
+    epicsThreadOnce(&type_once, &type_init, nullptr);
+    assert(type_gbl);
+
+    Guard G(type_gbl->lock);
+
+    size_t ret = 0u;
+    for(auto& pair : type_gbl->types) {
+        if(!pair.second.expired())
+            ret++;
+    }
+    return ret;
+}
+
 void show_FieldDesc(std::ostream& strm, const FieldDesc* desc, unsigned level)
 {
     for(auto idx : range(desc->size())) {
@@ -389,7 +566,6 @@ void show_FieldDesc(std::ostream& strm, const FieldDesc* desc, unsigned level)
 
         switch(fld.code.code) {
         case TypeCode::Struct:
-            // note: need to ensure stable lexical iteration order if fld.mlookup ever becomes unordered_map
             for(auto& pair : fld.mlookup) {
                 indent(strm, level);
                 strm<<"    "<<pair.first<<" -> "<<pair.second<<" ["<<(idx+pair.second)<<"]\n";
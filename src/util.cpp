@@ -74,6 +74,7 @@ CASE(ServerGPR);
 CASE(ServerGPRConnect);
 CASE(ServerGPRExec);
 CASE(MonitorOp);
+CASE(MonitorFanout);
 CASE(ServerMonitorControl);
 CASE(ServerMonitorSetup);
 CASE(SharedPVImpl);
@@ -111,6 +112,7 @@ CASE(ServerGPR);
 CASE(ServerGPRConnect);
 CASE(ServerGPRExec);
 CASE(MonitorOp);
+CASE(MonitorFanout);
 CASE(ServerMonitorControl);
 CASE(ServerMonitorSetup);
 CASE(SharedPVImpl);
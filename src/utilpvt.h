@@ -281,6 +281,7 @@ CASE(ServerGPR);
 CASE(ServerGPRConnect);
 CASE(ServerGPRExec);
 CASE(MonitorOp);
+CASE(MonitorFanout);
 CASE(ServerMonitorControl);
 CASE(ServerMonitorSetup);
 CASE(SharedPVImpl);
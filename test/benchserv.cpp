@@ -0,0 +1,115 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvxs is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include <epicsThread.h>
+
+#include <pvxs/client.h>
+#include <pvxs/server.h>
+#include <pvxs/sharedpv.h>
+#include <pvxs/nt.h>
+
+namespace {
+using namespace pvxs;
+
+typedef std::chrono::steady_clock clock_type;
+
+// issues batches of GETs through its own Context, so its own connection.
+// Batches keep the connection busy, rather than waiting out a round trip per GET.
+struct Getter : public epicsThreadRunable
+{
+    static constexpr size_t depth = 32u;
+
+    client::Context ctxt;
+    const clock_type::time_point until;
+    size_t count = 0u;
+    size_t errors = 0u;
+    epicsThread worker;
+
+    Getter(const server::Server& serv, clock_type::time_point until)
+        :ctxt(serv.clientConfig().build())
+        ,until(until)
+        ,worker(*this, "getter", epicsThreadGetStackSize(epicsThreadStackSmall))
+    {}
+
+    virtual ~Getter() {}
+
+    virtual void run() override final {
+        std::vector<std::shared_ptr<client::Operation>> ops(depth);
+        while(clock_type::now() < until) {
+            for(auto& op : ops)
+                op = ctxt.get("bench").exec();
+            for(auto& op : ops) {
+                try {
+                    (void)op->wait(5.0);
+                    count++;
+                }catch(std::exception&){
+                    errors++;
+                }
+            }
+        }
+    }
+};
+
+} // namespace
+
+/* Loopback GET throughput of a server with several workers.
+ * Each client thread has its own connection, and so is handled by one worker.
+ * Counts GETs completed until the time runs out, so the last batch may overrun.
+ *
+ *   benchserv [seconds] [clients] [max workers]
+ *
+ * Scaling is only meaningful with at least as many CPU cores as workers plus clients.
+ */
+int main(int argc, char *argv[])
+{
+    double seconds = argc>1 ? strtod(argv[1], nullptr) : 2.0;
+    size_t nclient = argc>2 ? strtoul(argv[2], nullptr, 0) : 8u;
+    unsigned maxworkers = argc>3 ? strtoul(argv[3], nullptr, 0) : epicsThreadGetCPUs();
+
+    auto initial(nt::NTScalar{TypeCode::Float64A}.create());
+    initial["value"] = shared_array<const double>(1024u, 1.0);
+
+    auto pv(server::SharedPV::buildReadonly());
+    pv.open(initial);
+
+    std::cout<<"# "<<epicsThreadGetCPUs()<<" CPUs, "<<nclient<<" clients\n"
+               "workers\tGET/s\terrors\n";
+
+    for(unsigned workers=1u; workers<=maxworkers; workers*=2u) {
+        auto conf(server::Config::isolated());
+        conf.workers = workers;
+        auto serv = conf.build()
+                .addPV("bench", pv)
+                .start();
+
+        auto until(clock_type::now() + std::chrono::microseconds(int64_t(seconds*1e6)));
+        std::vector<std::unique_ptr<Getter>> getters;
+        for(size_t i=0u; i<nclient; i++) {
+            getters.emplace_back(new Getter(serv, until));
+            getters.back()->worker.start();
+        }
+
+        size_t count = 0u, errors = 0u;
+        for(auto& getter : getters) {
+            getter->worker.exitWait();
+            count += getter->count;
+            errors += getter->errors;
+        }
+
+        std::cout<<workers<<"\t"<<(count/seconds)<<"\t"<<errors<<"\n";
+
+        serv.stop();
+    }
+
+    return 0;
+}
@@ -0,0 +1,234 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvxs is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+
+#include <epicsMutex.h>
+#include <epicsGuard.h>
+
+#include <pvxs/data.h>
+#include <pvxs/nt.h>
+#include "bitmask.h"
+#include "dataimpl.h"
+#include "pvaproto.h"
+#include "spscring.h"
+
+namespace {
+using namespace pvxs;
+using namespace pvxs::impl;
+
+typedef std::chrono::steady_clock clock_type;
+
+template<typename Fn>
+void bench(const char* name, size_t count, Fn&& fn)
+{
+    // warm up
+    for(auto i : range(count/10u)) {
+        (void)i;
+        fn();
+    }
+
+    auto start(clock_type::now());
+    for(auto i : range(count)) {
+        (void)i;
+        fn();
+    }
+    auto elapsed(std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - start));
+
+    std::cout<<name<<"\t"<<(double(elapsed.count())/count)<<" ns/op\n";
+}
+
+} // namespace
+
+/* Micro-benchmarks for (de)serialization of a typical NTScalar.
+ *
+ *   benchxcode [iterations]
+ */
+int main(int argc, char *argv[])
+{
+    size_t count = argc>1 ? strtoul(argv[1], nullptr, 0) : 1000000u;
+
+    auto val = nt::NTScalar{TypeCode::Float64, true, true, true}.create();
+    val["value"] = 42.0;
+    val["alarm.severity"] = 1;
+    val["alarm.message"] = "HIGH";
+    val["timeStamp.secondsPastEpoch"] = 1234567890;
+    val["timeStamp.nanoseconds"] = 123456789;
+    val["display.units"] = "mm";
+    val["display.limitLow"] = -10.0;
+    val["display.limitHigh"] = 10.0;
+
+    bench("lookup_name", count, [&val]() {
+        val["timeStamp.nanoseconds"] = 5;
+    });
+
+    const FieldRef nsRef(val, "timeStamp.nanoseconds");
+    bench("lookup_ref", count, [&val, &nsRef]() {
+        val[nsRef] = 5;
+    });
+
+    {
+        // fill the fields of a feedback loop update
+        struct Reading {
+            double value;
+            int32_t severity;
+            int32_t sec;
+            int32_t nsec;
+        };
+        const Reading r{42.0, 0, 1234567890, 123456789};
+        auto rmap(makeStructMap(val,
+                                mapMember("value", &Reading::value),
+                                mapMember("alarm.severity", &Reading::severity),
+                                mapMember("timeStamp.secondsPastEpoch", &Reading::sec),
+                                mapMember("timeStamp.nanoseconds", &Reading::nsec)));
+        auto dest = val.cloneEmpty();
+
+        bench("fill_name", count, [&dest, &r]() {
+            dest["value"] = r.value;
+            dest["alarm.severity"] = r.severity;
+            dest["timeStamp.secondsPastEpoch"] = r.sec;
+            dest["timeStamp.nanoseconds"] = r.nsec;
+        });
+
+        bench("fill_structmap", count, [&dest, &r, &rmap]() {
+            rmap.encode(dest, r);
+        });
+
+        bench("decode_structmap", count, [&dest, &rmap]() {
+            volatile int32_t n = rmap.decode(dest).nsec;
+            (void)n;
+        });
+    }
+
+    {
+        // squash a one field update, as a monitor queue does
+        auto dest = val.clone();
+        auto update = val.cloneEmpty();
+        update["value"] = 43.0;
+        bench("assign_squash", count, [&dest, &update]() {
+            dest.assign(update);
+        });
+    }
+
+    std::vector<uint8_t> buf;
+    buf.reserve(1024u);
+
+    bench("to_wire_full", count, [&val, &buf]() {
+        buf.resize(1024u);
+        VectorOutBuf S(hostBE, buf);
+        to_wire_full(S, val);
+    });
+
+    {
+        // type of an operation INIT reply, already sent on this connection
+        TxTypeStore txcache;
+        auto type(Value::Helper::type(val));
+        bench("to_wire_type_cached", count, [&txcache, &type, &buf]() {
+            buf.resize(1024u);
+            VectorOutBuf S(hostBE, buf);
+            to_wire(S, type, txcache);
+        });
+    }
+
+    // a typical monitor update
+    val.unmark();
+    val["value"] = 43.0;
+    val["timeStamp.secondsPastEpoch"] = 1234567891;
+    val["timeStamp.nanoseconds"] = 0;
+
+    bench("to_wire_valid", count, [&val, &buf]() {
+        buf.resize(1024u);
+        VectorOutBuf S(hostBE, buf);
+        to_wire_valid(S, val);
+    });
+
+    bench("encoded_size_valid", count, [&val]() {
+        volatile size_t n = encoded_size_valid(val);
+        (void)n;
+    });
+
+    {
+        // changed field mask of a moderately large structure
+        BitMask mask({3, 40, 99}, 100u);
+        bench("bitmask_iter", count, [&mask]() {
+            size_t n = 0u;
+            for(auto bit = mask.findSet(0u); bit < mask.size(); bit = mask.findSet(bit+1u))
+                n += bit;
+            volatile size_t sink = n;
+            (void)sink;
+        });
+
+        bench("bitmask_wire", count, [&mask, &buf]() {
+            buf.resize(1024u);
+            VectorOutBuf S(hostBE, buf);
+            to_wire(S, mask);
+            buf.resize(buf.size()-S.size());
+            FixedBuf R(hostBE, buf);
+            BitMask out;
+            from_wire(R, out);
+        });
+    }
+
+    std::vector<uint8_t> encoded(1024u);
+    {
+        VectorOutBuf S(hostBE, encoded);
+        to_wire_valid(S, val);
+        encoded.resize(encoded.size()-S.size());
+    }
+    auto val2 = val.cloneEmpty();
+    TypeStore ctxt;
+
+    bench("from_wire_valid", count, [&val2, &ctxt, &encoded]() {
+        FixedBuf S(hostBE, encoded);
+        from_wire_valid(S, ctxt, val2);
+    });
+
+    {
+        // a server monitor queue of 4, posted to twice as often as it is emptied.
+        // Entries share one update, as with SharedPV.  When full, the newest entry is replaced.
+        const size_t limit = 4u;
+        auto update(val.clone());
+        update["value"] = 43.0;
+        size_t n = 0u;
+
+        std::deque<Value> dq;
+        epicsMutex lock;
+        Value out;
+        bench("monq_deque", count, [&dq, &lock, &update, &n, &out, limit]() {
+            {
+                epicsGuard<epicsMutex> G(lock);
+                if(dq.size() < limit)
+                    dq.push_back(update);
+                else
+                    dq.back() = update;
+            }
+            if(n++&1u) {
+                epicsGuard<epicsMutex> G(lock);
+                out = std::move(dq.front());
+                dq.pop_front();
+            }
+        });
+
+        // as MonitorOp, producers are serialized by a lock which the consumer does not take
+        SPSCRing<Value> ring(limit+1u);
+        bench("monq_ring", count, [&ring, &lock, &update, &n, &out, limit]() {
+            {
+                epicsGuard<epicsMutex> G(lock);
+                Value ent(update);
+                if(ring.size() >= limit)
+                    (void)ring.unpush(out); // replace the newest
+                (void)ring.push(ent);
+            }
+            if(n++&1u)
+                (void)ring.pop(out);
+        });
+    }
+
+    return 0;
+}
@@ -195,11 +195,87 @@ void testSer()
     }
 }
 
+void testGrow()
+{
+    testDiag("%s", __func__);
+
+    BitMask M({0, 63, 64, 99}, 100u);
+    testEq(M.wsize(), 2u);
+    testEq(M.count(), 4u);
+
+    // beyond inline storage
+    M.resize(300u);
+    testEq(M.size(), 300u);
+    testEq(M.wsize(), 5u);
+    testEq(std::string(SB()<<M), "{0, 63, 64, 99}");
+
+    M[299] = true;
+    M[256] = true;
+    testEq(M.count(), 6u);
+    testEq(M.findSet(100u), 256u);
+    testEq(M.findSet(257u), 299u);
+    testEq(M.findSet(300u), 300u);
+
+    M.resize(65u);
+    testEq(M.wsize(), 2u);
+    testEq(M.findSet(1u), 63u);
+    testEq(M.findSet(65u), 65u);
+}
+
+void testMove()
+{
+    testDiag("%s", __func__);
+
+    BitMask small({2}, 10u);
+    BitMask big({1, 200}, 201u);
+
+    BitMask A(std::move(small));
+    testEq(std::string(SB()<<A), "{2}");
+    testOk1(small.empty());
+
+    BitMask B(std::move(big));
+    testEq(std::string(SB()<<B), "{1, 200}");
+    testOk1(big.empty());
+    testEq(big.wsize(), 0u);
+
+    // heap -> inline, inline -> heap
+    A = std::move(B);
+    testEq(std::string(SB()<<A), "{1, 200}");
+    B = BitMask({5}, 6u);
+    testEq(std::string(SB()<<B), "{5}");
+
+    // moved from remains usable
+    big.resize(130u);
+    big[129] = true;
+    testEq(std::string(SB()<<big), "{129}");
+}
+
+void testSerWide()
+{
+    testDiag("%s", __func__);
+
+    for(auto be : {true, false}) {
+        BitMask M({0, 64, 127, 128, 300, 511}, 512u);
+
+        std::vector<uint8_t> O;
+        VectorOutBuf outbuf(be, O);
+        to_wire(outbuf, M);
+        testEq(O.size()-outbuf.size(), 1u+64u)<<" be="<<be;
+
+        O.resize(O.size()-outbuf.size());
+        BitMask N;
+        FixedBuf inbuf(be, O);
+        from_wire(inbuf, N);
+        testOk1(inbuf.good());
+        testEq(std::string(SB()<<N), "{0, 64, 127, 128, 300, 511}");
+    }
+}
+
 } // namespace
 
 MAIN(testbitmask)
 {
-    testPlan(76);
+    testPlan(102);
     testSetup();
     testEmpty();
     testBasic1();
@@ -208,6 +284,9 @@ MAIN(testbitmask)
     testOp();
     testExpr();
     testSer();
+    testGrow();
+    testMove();
+    testSerWide();
     cleanup_for_valgrind();
     return testDone();
 }
@@ -29,7 +29,7 @@ void testParse()
     epicsEnvSet("EPICS_PVA_ADDR_LIST", "  1.2.3.4  5.6.7.8:9876  ");
     epicsEnvSet("EPICS_PVA_AUTO_ADDR_LIST", "NO");
     epicsEnvSet("EPICS_PVA_BROADCAST_PORT", "1234");
-
+    epicsEnvSet("EPICS_PVA_VALUE_POOL", "3");
 
     client::Config conf;
     try {
@@ -43,11 +43,13 @@ void testParse()
         testEq(conf.addressList[0], "1.2.3.4:1234");
         testEq(conf.addressList[1], "5.6.7.8:9876");
     }
+    testEq(conf.valuePoolLimit, 3u);
 
 #ifdef HAVE_ENV_UNSET
     epicsEnvUnset("EPICS_PVA_ADDR_LIST");
     epicsEnvUnset("EPICS_PVA_AUTO_ADDR_LIST");
     epicsEnvUnset("EPICS_PVA_BROADCAST_PORT");
+    epicsEnvUnset("EPICS_PVA_VALUE_POOL");
 #endif
 }
 
@@ -55,7 +57,7 @@ void testParse()
 
 MAIN(testconfig)
 {
-    testPlan(4);
+    testPlan(5);
     testSetup();
     logger_config_env();
     testParse();
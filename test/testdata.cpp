@@ -69,6 +69,8 @@ void testName()
 
     testEq(val.nameOf(val["value"]), "value");
     testEq(val.nameOf(val["alarm.status"]), "alarm.status");
+    testEq(val["alarm"].nameOf(val["alarm.status"]), "status");
+    testTrue(&val.nameOf(val["value"])==&val.nameOf(val["value"]))<<" stored by type";
 
     testThrows<std::logic_error>([&val]() {
         val.nameOf(val);
@@ -192,6 +194,45 @@ void testConvertScalar(const Store& store, const Inout& inout)
     testEq(inout, cont.as<Inout>())<<typeid(Store).name()<<"->"<<typeid(Inout).name();
 }
 
+void testAssignSame()
+{
+    testShow()<<__func__;
+
+    auto def = nt::NTScalar{TypeCode::Float64, true}.build();
+    auto val1 = def.create();
+    auto val2 = def.create();
+
+    val1["value"] = 1.0;
+    val1["display.description"] = "original";
+    val1["alarm.severity"] = 2;
+    val1.unmark();
+
+    val2["value"] = 4.0;
+    val2["alarm.message"] = "changed";
+    val2["display.description"] = "ignored";
+    val2["display.description"].unmark();
+
+    // same type, so copies marked fields by index
+    val1.assign(val2);
+    testEq(val1["value"].as<double>(), 4.0);
+    testTrue(val1["value"].isMarked());
+    testEq(val1["alarm.message"].as<std::string>(), "changed");
+    testTrue(val1["alarm.message"].isMarked());
+    testEq(val1["alarm.severity"].as<int32_t>(), 2)<<" unchanged";
+    testFalse(val1["alarm.severity"].isMarked());
+    testEq(val1["display.description"].as<std::string>(), "original");
+    testFalse(val1["display"].isMarked(true, true));
+    testFalse(val1.isMarked(false, false));
+
+    val2.unmark();
+    val2["alarm"].mark();
+    val2.mark();
+    val1.assign(val2);
+    testTrue(val1["alarm"].isMarked(false, false));
+    testEq(val1["alarm.severity"].as<int32_t>(), 2)<<" member of marked sub-struct not copied";
+    testTrue(val1.isMarked(false, false));
+}
+
 void testAssignSimilar()
 {
     testShow()<<__func__;
@@ -257,11 +298,299 @@ void testAssignSimilar()
     }
 }
 
+void testFieldRef()
+{
+    testDiag("%s", __func__);
+
+    auto proto(nt::NTScalar{TypeCode::Float64}.create());
+
+    const FieldRef value(proto, "value"), sec(proto, "timeStamp.secondsPastEpoch"), ts(proto, "timeStamp");
+    testEq(sec.name(), "timeStamp.secondsPastEpoch");
+
+    auto val(proto.cloneEmpty());
+    val[value] = 4.5;
+    val[sec] = 1234;
+    testEq(val["value"].as<double>(), 4.5);
+    testEq(val["timeStamp.secondsPastEpoch"].as<int64_t>(), 1234);
+    testOk1(!!val["timeStamp.secondsPastEpoch"].isMarked());
+    testEq(val[ts]["secondsPastEpoch"].as<int64_t>(), 1234);
+
+    const Value cval(val);
+    testEq(cval[value].as<double>(), 4.5);
+
+    // a different type with the same field names
+    auto other(nt::NTScalar{TypeCode::Int32, true}.create());
+    other[sec] = 5;
+    testEq(other["timeStamp.secondsPastEpoch"].as<int64_t>(), 5);
+
+    // no such field in a different type
+    testFalse(TypeDef(TypeCode::Struct, {}).create()[value].valid());
+    testFalse(Value()[value].valid());
+    testFalse(val[FieldRef()].valid());
+
+    testThrows<NoField>([&proto]() {
+        FieldRef(proto, "nonexistent");
+    });
+
+    auto u(TypeDef(TypeCode::Struct, {
+                       members::Union("u", {
+                           members::Int32("a"),
+                       }),
+                   }).create());
+    u["u->a"] = 1;
+    testThrows<std::logic_error>([&u]() {
+        FieldRef(u, "u->a");
+    });
+}
+
+void testValuePool()
+{
+    testDiag("%s", __func__);
+
+    auto proto(nt::NTScalar{TypeCode::Float64}.create());
+    auto pool(std::make_shared<ValuePool>(1u));
+
+    auto val1(Value::Helper::cloneEmpty(proto, pool));
+    auto val2(Value::Helper::cloneEmpty(proto, pool));
+    testEq(pool->misses.load(), 2u);
+    testEq(pool->hits.load(), 0u);
+
+    val1["value"] = 4.0;
+    testEq(val1["value"].as<double>(), 4.0);
+    testEq(std::string(SB()<<val1.cloneEmpty()), std::string(SB()<<proto));
+
+    // only one is kept
+    val1 = Value();
+    val2 = Value();
+
+    auto val3(Value::Helper::cloneEmpty(proto, pool));
+    testEq(pool->hits.load(), 1u);
+    testFalse(val3["value"].isMarked())<<" storage is re-initialized";
+    testEq(val3["value"].as<double>(), 0.0);
+
+    // outlives pool
+    pool.reset();
+    val3["alarm.message"] = "still here";
+    testEq(val3["alarm.message"].as<std::string>(), "still here");
+}
+
+void testFreeze()
+{
+    testDiag("%s", __func__);
+
+    auto inner(nt::NTScalar{TypeCode::Int32}.create());
+    inner["value"] = 5;
+
+    auto val(TypeDef(TypeCode::Struct, {
+                         members::Int32("x"),
+                         members::Any("any"),
+                     }).create());
+    val["x"] = 1;
+    val["any"].from(inner);
+
+    auto snap(val.clone().freeze());
+    testTrue(snap.isFrozen());
+    testFalse(val.isFrozen());
+    testEq(snap["x"].as<int32_t>(), 1);
+
+    testThrows<std::logic_error>([&snap]() {
+        snap["x"] = 2;
+    });
+    testThrows<std::logic_error>([&snap]() {
+        snap["x"].unmark();
+    });
+    testThrows<std::logic_error>([&snap]() {
+        snap["any->value"] = 2; // Any member frozen as well
+    });
+    testFalse(inner.isFrozen())<<" shared with clone(), so a copy is frozen";
+    inner["value"] = 6;
+    testEq(snap["any->value"].as<int32_t>(), 5)<<" unaffected by original";
+
+    // elements of a Value[] shared with the original are also copied
+    auto sarr(TypeDef(TypeCode::Struct, {
+                          members::StructA("arr", {
+                              members::Int32("y"),
+                          }),
+                      }).create());
+    {
+        auto fld(sarr["arr"]);
+        shared_array<Value> arr(2);
+        (arr[0] = fld.allocMember())["y"] = 1;
+        // arr[1] left null
+        fld = arr.freeze().castTo<const void>();
+    }
+    auto elem(sarr["arr[0]"]);
+    auto asnap(sarr.clone().freeze());
+    testFalse(elem.isFrozen());
+    testTrue(asnap["arr[0]"].isFrozen());
+    elem["y"] = 2;
+    testEq(asnap["arr[0].y"].as<int32_t>(), 1)<<" unaffected by original";
+
+    val["x"] = 3;
+    testEq(snap["x"].as<int32_t>(), 1)<<" unaffected by original";
+
+    auto copy(snap.thaw());
+    testFalse(copy.isFrozen());
+    testFalse(copy.compareInst(snap));
+    copy["x"] = 4;
+    testEq(copy["x"].as<int32_t>(), 4);
+    testTrue(val.thaw().compareInst(val))<<" no copy unless frozen";
+}
+
+void testBatch()
+{
+    testDiag("%s", __func__);
+
+    auto proto(nt::NTScalar{TypeCode::Float64}.create());
+
+    ValueBatch batch(proto);
+    testEq(batch.size(), 0u);
+    auto vcol = batch.find("value");
+    auto mcol = batch.find("alarm.message");
+    auto scol = batch.find("alarm.severity");
+    testEq(batch.name(vcol), "value");
+    testTrue(batch.storageType(vcol)==StoreType::Real);
+    testTrue(batch.storageType(mcol)==StoreType::String);
+    testThrows<NoField>([&batch]() {
+        batch.find("alarm"); // not a leaf
+    });
+
+    batch.reserve(3u);
+    for(auto i : range(3)) {
+        auto update(proto.cloneEmpty());
+        update["value"] = 1.5*i;
+        if(i!=1)
+            update["alarm.message"] = std::string(SB()<<"msg"<<i);
+        if(i==2)
+            update["alarm"].mark(); // whole sub-struct
+        batch.append(update);
+    }
+    testEq(batch.size(), 3u);
+
+    auto values(batch.column<double>(vcol));
+    testArrEq(values, shared_array<const double>({0.0, 1.5, 3.0}));
+    auto msgs(batch.column<std::string>(mcol));
+    testArrEq(msgs, shared_array<const std::string>({"msg0", "", "msg2"}));
+
+    testTrue(batch[1].isMarked(vcol));
+    testTrue(batch[0].isMarked(mcol));
+    testFalse(batch[1].isMarked(mcol));
+    testFalse(batch[0].isMarked(scol));
+    testTrue(batch[2].isMarked(scol))<<" through alarm";
+
+    testEq(batch[2].as<std::string>(mcol), "msg2");
+    testEq(batch[1].as<int32_t>(vcol), 1)<<" converted";
+    testEq(batch[2].as<std::string>(vcol), "3");
+
+    size_t n = 0u;
+    double sum = 0.0;
+    for(auto& row : batch) {
+        testEq(row.index(), n);
+        sum += row.as<double>(vcol);
+        n++;
+    }
+    testEq(n, 3u);
+    testEq(sum, 4.5);
+
+    auto val(batch.value(0u));
+    testTrue(val.compareType(proto));
+    testEq(val["value"].as<double>(), 0.0);
+    testEq(val["alarm.message"].as<std::string>(), "msg0");
+    testTrue(val["alarm.message"].isMarked(false));
+    testFalse(val["alarm.severity"].isMarked());
+
+    testThrows<std::logic_error>([&batch]() {
+        batch.append(nt::NTScalar{TypeCode::Int32}.create());
+    });
+    testThrows<std::out_of_range>([&batch]() {
+        batch.isMarked(3u, 0u);
+    });
+
+    batch.clear();
+    testEq(batch.size(), 0u);
+    testEq(batch.column(vcol).size(), 0u);
+
+    // rows of an Any column are read out as copies
+    auto aproto(TypeDef(TypeCode::Struct, {
+                            members::Any("any"),
+                        }).create());
+    ValueBatch abatch(aproto);
+    {
+        auto update(aproto.cloneEmpty());
+        update["any"].from(nt::NTScalar{TypeCode::Int32}.create().update("value", 5));
+        abatch.append(update);
+    }
+    auto acol = abatch.find("any");
+    auto mem(abatch[0].as<Value>(acol));
+    mem["value"] = 6;
+    Value elem(abatch.column<Value>(acol)[0]);
+    elem["value"] = 7;
+    testEq(abatch[0].as<Value>(acol)["value"].as<int32_t>(), 5)<<" stored row unchanged";
+}
+
+struct Reading {
+    double value;
+    int32_t severity;
+    std::string message;
+    bool flag;
+};
+
+void testStructMap()
+{
+    testDiag("%s", __func__);
+
+    auto def(nt::NTScalar{TypeCode::Float64}.build());
+    def += {members::Bool("flag")};
+    auto proto(def.create());
+
+    auto rmap(makeStructMap(proto,
+                            mapMember("value", &Reading::value),
+                            mapMember("alarm.severity", &Reading::severity),
+                            mapMember("alarm.message", &Reading::message),
+                            mapMember("flag", &Reading::flag)));
+
+    auto val(rmap.encode(Reading{1.5, 2, "hello", true}));
+    testTrue(val.compareType(proto));
+    testEq(val["value"].as<double>(), 1.5);
+    testEq(val["alarm.severity"].as<int32_t>(), 2);
+    testEq(val["alarm.message"].as<std::string>(), "hello");
+    testEq(val["flag"].as<bool>(), true);
+    testTrue(val["alarm.severity"].isMarked(false));
+    testFalse(val["alarm.status"].isMarked());
+
+    val["value"] = 3.0;
+    val["alarm.severity"] = "5"; // string
+    auto r(rmap.decode(val));
+    testEq(r.value, 3.0);
+    testEq(r.severity, 5);
+    testEq(r.message, "hello");
+    testEq(r.flag, true);
+
+    // same field names, different type.  Falls back to lookup by name
+    auto odef(nt::NTScalar{TypeCode::Int32}.build());
+    odef += {members::Bool("flag")};
+    auto other(odef.create());
+    rmap.encode(other, Reading{7.0, 1, "x", false});
+    testEq(other["value"].as<int32_t>(), 7);
+    testThrows<NoField>([&rmap]() {
+        rmap.decode(nt::NTScalar{TypeCode::Int32}.create()); // no "flag"
+    });
+
+    testThrows<NoField>([&proto]() {
+        makeStructMap(proto, mapMember("nonexistent", &Reading::value));
+    });
+
+    auto frozen(rmap.create().freeze());
+    testThrows<std::logic_error>([&rmap, &frozen]() {
+        rmap.encode(frozen, Reading{});
+    });
+}
+
 } // namespace
 
 MAIN(testdata)
 {
-    testPlan(78);
+    testPlan(174);
     testSetup();
     testTraverse();
     testAssign();
@@ -289,7 +618,13 @@ MAIN(testdata)
     testConvertScalar<std::string, int32_t>("-5", -5);
     testConvertScalar<std::string, double>("-5", -5.0);
     testConvertScalar<std::string, std::string>("-5", "-5");
+    testAssignSame();
     testAssignSimilar();
+    testFieldRef();
+    testValuePool();
+    testFreeze();
+    testBatch();
+    testStructMap();
     cleanup_for_valgrind();
     return testDone();
 }
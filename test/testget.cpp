@@ -4,13 +4,16 @@
  * in file LICENSE that is included with this distribution.
  */
 
+#include <algorithm>
 #include <atomic>
+#include <vector>
 
 #include <testMain.h>
 
 #include <epicsUnitTest.h>
 
 #include <epicsEvent.h>
+#include <epicsThread.h>
 
 #include <pvxs/unittest.h>
 #include <pvxs/log.h>
@@ -99,6 +102,35 @@ struct Tester {
         testWait();
     }
 
+    void large()
+    {
+        testShow()<<__func__;
+
+        // a message body much larger than the socket buffers,
+        // received over many reads
+        shared_array<double> arr(1024u*1024u);
+        for(size_t i=0; i<arr.size(); i++)
+            arr[i] = double(i);
+
+        auto big(nt::NTScalar{TypeCode::Float64A}.create());
+        big["value"] = arr.freeze();
+
+        mbox.open(big);
+        serv.start();
+
+        auto op = cli.get("mailbox").exec();
+
+        cli.hurryUp();
+
+        auto result = op->wait(10.0);
+
+        auto val = result["value"].as<shared_array<const double>>();
+        bool match = val.size()==1024u*1024u;
+        for(size_t i=0; match && i<val.size(); i++)
+            match = val[i]==double(i);
+        testTrue(match)<<" size="<<val.size();
+    }
+
     void lazy()
     {
         testShow()<<__func__;
@@ -241,20 +273,247 @@ void testError(bool phase)
     }
 }
 
+void testWorkers(unsigned workers, unsigned listeners)
+{
+    testShow()<<__func__<<" workers="<<workers<<" listeners="<<listeners;
+
+    auto initial(nt::NTScalar{TypeCode::Int32}.create());
+    initial["value"] = 42;
+
+    auto mbox(server::SharedPV::buildReadonly());
+    mbox.open(initial);
+
+    auto conf(server::Config::isolated());
+    conf.workers = workers;
+    conf.tcp_listeners = listeners;
+    conf.listen_backlog = 16u;
+    auto serv = conf.build()
+            .addPV("mailbox", mbox)
+            .start();
+
+    // at least one worker per listener
+    testEq(serv.config().workers, std::max(workers, serv.config().tcp_listeners));
+
+    // each Context makes its own connection, so these are spread across workers
+    std::vector<client::Context> clis;
+    std::vector<std::shared_ptr<client::Operation>> ops;
+    for(size_t i=0; i<6u; i++) {
+        clis.push_back(serv.clientConfig().build());
+        ops.push_back(clis.back().get("mailbox").exec());
+        clis.back().hurryUp();
+    }
+
+    for(auto& op : ops) {
+        auto result = op->wait(5.0);
+        testEq(result["value"].as<int32_t>(), 42);
+    }
+
+    // stop with connections still open on each worker
+    serv.stop();
+    testPass("stopped");
+}
+
+// onFirstConnect and onLastDisconnect alternate when channels come and go on several workers
+void testFirstLastWorkers()
+{
+    testShow()<<__func__;
+
+    auto initial(nt::NTScalar{TypeCode::Int32}.create());
+    initial["value"] = 42;
+
+    auto mbox(server::SharedPV::buildReadonly());
+    mbox.open(initial);
+
+    std::atomic<unsigned> inCB{0u}, nFirst{0u}, nLast{0u};
+    std::atomic<bool> connected{false}, ok{true};
+    epicsEvent disconn;
+
+    mbox.onFirstConnect([&](){
+        ok = ok && inCB++==0u && !connected.exchange(true);
+        epicsThreadSleep(0.001);
+        inCB--;
+        nFirst++;
+    });
+    mbox.onLastDisconnect([&](){
+        ok = ok && inCB++==0u && connected.exchange(false);
+        epicsThreadSleep(0.001);
+        inCB--;
+        nLast++;
+        disconn.signal();
+    });
+
+    auto conf(server::Config::isolated());
+    conf.workers = 4u;
+    auto serv = conf.build()
+            .addPV("mailbox", mbox)
+            .start();
+
+    for(unsigned round=0u; round<5u; round++) {
+        std::vector<client::Context> clis;
+        std::vector<std::shared_ptr<client::Operation>> ops;
+        for(size_t i=0; i<6u; i++) {
+            clis.push_back(serv.clientConfig().build());
+            ops.push_back(clis.back().get("mailbox").exec());
+            clis.back().hurryUp();
+        }
+        for(auto& op : ops)
+            ok = ok && op->wait(5.0)["value"].as<int32_t>()==42;
+    }
+
+    while(nFirst.load()!=nLast.load() && disconn.wait(5.0)) {}
+
+    testOk(ok.load(), "callbacks serialized and alternating");
+    testOk(!connected.load() && nFirst.load()==nLast.load() && nFirst.load()>0u,
+           "%u first, %u last", nFirst.load(), nLast.load());
+}
+
+void testLimits()
+{
+    testShow()<<__func__;
+
+    // a message much larger than all of the flow control limits
+    shared_array<double> arr(0x10000u);
+    for(size_t i=0; i<arr.size(); i++)
+        arr[i] = double(i);
+
+    auto big(nt::NTScalar{TypeCode::Float64A}.create());
+    big["value"] = arr.freeze();
+
+    auto mbox(server::SharedPV::buildReadonly());
+    mbox.open(big);
+
+    auto sconf(server::Config::isolated());
+    sconf.tcp_tx_high = 0x1000u;
+    sconf.tcp_tx_low = 0x2000u; // clamped to tcp_tx_high
+    sconf.tcp_tx_drain = 1u;
+    sconf.tcp_readahead = 0u; // raised to 8
+    auto serv = sconf.build()
+            .addPV("mailbox", mbox)
+            .start();
+
+    testEq(serv.config().tcp_tx_low, 0x1000u);
+    testEq(serv.config().tcp_readahead, 8u);
+
+    auto cconf(serv.clientConfig());
+    cconf.tcp_readahead = 8u;
+    auto cli = cconf.build();
+
+    for(unsigned n=0; n<2u; n++) {
+        auto result = cli.get("mailbox").exec()->wait(10.0);
+
+        auto val = result["value"].as<shared_array<const double>>();
+        bool match = val.size()==0x10000u;
+        size_t i=0;
+        for(; match && i<val.size(); i++)
+            match = val[i]==double(i);
+        testTrue(match)<<" size="<<val.size()<<" at "<<i;
+    }
+}
+
+void testTypeCache()
+{
+    testShow()<<__func__;
+
+    // type descriptions longer than one segment
+    auto bigType = [](const char* id) {
+        std::vector<Member> fields;
+        for(unsigned i=0u; i<4096u; i++)
+            fields.push_back(members::Int32("a_rather_long_field_name_"+std::to_string(i)));
+        return TypeDef(TypeCode::Struct, id, fields).create();
+    };
+
+    auto pv1(server::SharedPV::buildReadonly());
+    auto pv2(server::SharedPV::buildReadonly());
+    pv1.open(bigType("test:big1_t"));
+    pv2.open(bigType("test:big2_t"));
+
+    auto serv = server::Config::isolated()
+            .build()
+            .addPV("big1", pv1)
+            .addPV("big2", pv2)
+            .start();
+    auto cli = serv.clientConfig().build();
+
+    // While the first INIT reply is being sent, the second is queued, and defines
+    // the type cache key which the third refers to.  The third is short, and for
+    // another ioid, but must not be sent ahead of the second.
+    std::shared_ptr<client::Operation> ops[] = {
+        cli.get("big1").exec(),
+        cli.get("big2").exec(),
+        cli.get("big2").exec(),
+    };
+    cli.hurryUp();
+
+    for(auto& op : ops) {
+        try {
+            auto result = op->wait(5.0);
+            testTrue(result.type()==TypeCode::Struct)<<" "<<result.id();
+        }catch(std::exception& e){
+            testFail("Unexpected %s : %s", typeid(e).name(), e.what());
+        }
+    }
+}
+
+void testPostAny()
+{
+    testShow()<<__func__;
+
+    auto inner(nt::NTScalar{TypeCode::Int32}.create());
+    inner["value"] = 5;
+
+    auto val(TypeDef(TypeCode::Struct, {
+                         members::Any("any"),
+                     }).create());
+    val["any"].from(inner);
+
+    auto mbox(server::SharedPV::buildReadonly());
+    mbox.open(val);
+
+    auto serv = server::Config::isolated()
+            .build()
+            .addPV("mailbox", mbox)
+            .start();
+    auto cli = serv.clientConfig().build();
+
+    // GET replies with a frozen snapshot of what was posted
+    testEq(cli.get("mailbox").exec()->wait(5.0)["any->value"].as<int32_t>(), 5);
+
+    // which must not freeze the caller's Any member
+    for(int32_t v : {6, 7}) {
+        try {
+            val["any->value"] = v;
+            testEq(inner["value"].as<int32_t>(), v);
+        }catch(std::exception& e){
+            testFail("Unexpected %s : %s", typeid(e).name(), e.what());
+        }
+
+        Value post(val);
+        mbox.post(std::move(post));
+        testEq(cli.get("mailbox").exec()->wait(5.0)["any->value"].as<int32_t>(), v);
+    }
+}
+
 } // namespace
 
 MAIN(testget)
 {
-    testPlan(15);
+    testPlan(46);
     testSetup();
     logger_config_env();
     Tester().testWaiter();
     Tester().loopback();
+    Tester().large();
     Tester().lazy();
     Tester().timeout();
     Tester().cancel();
     testError(false);
     testError(true);
+    testWorkers(4u, 1u);
+    testWorkers(1u, 3u);
+    testFirstLastWorkers();
+    testLimits();
+    testTypeCache();
+    testPostAny();
     cleanup_for_valgrind();
     return testDone();
 }
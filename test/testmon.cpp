@@ -32,10 +32,10 @@ struct BasicTest {
     epicsEvent evt;
     std::shared_ptr<client::Subscription> sub;
 
-    BasicTest()
+    explicit BasicTest(const server::Config& conf = server::Config::isolated())
         :initial(nt::NTScalar{TypeCode::Int32}.create())
         ,mbox(server::SharedPV::buildReadonly())
-        ,serv(server::Config::isolated()
+        ,serv(conf
               .build()
               .addPV("mailbox", mbox))
         ,cli(serv.clientConfig().build())
@@ -146,6 +146,8 @@ struct TestLifeCycle : public BasicTest
     {
         testShow()<<__func__<<" "<<howdisconn;
         phase1();
+        // storage of the first update is recycled for the second
+        testTrue(cli.poolStats().hits>=1u)<<" hits="<<cli.poolStats().hits<<" misses="<<cli.poolStats().misses;
         phase2(howdisconn);
         testFalse(sub->pop())<<"No events after Disconnect";
     }
@@ -193,6 +195,56 @@ struct TestLifeCycle : public BasicTest
     }
 };
 
+struct TestFanout : public BasicTest
+{
+    void testFanout()
+    {
+        testShow()<<__func__;
+
+        serv.start();
+        mbox.open(initial);
+        subscribe("mailbox");
+
+        // a second subscriber with the same pvRequest, and a third with a different pvRequest
+        epicsEvent evt2, evt3;
+        auto sub2 = cli.monitor("mailbox")
+                        .maskConnected(true)
+                        .maskDisconnected(false)
+                        .event([&evt2](client::Subscription& sub) {
+                            evt2.signal();
+                        })
+                        .exec();
+        auto sub3 = cli.monitor("mailbox")
+                        .field("value")
+                        .maskConnected(true)
+                        .maskDisconnected(false)
+                        .event([&evt3](client::Subscription& sub) {
+                            evt3.signal();
+                        })
+                        .exec();
+
+        cli.hurryUp();
+
+        testThrows<client::Connected>([this](){
+            pop(sub, evt);
+        });
+
+        testEq(pop(sub, evt)["value"].as<int32_t>(), 42);
+        testEq(pop(sub2, evt2)["value"].as<int32_t>(), 42);
+        testEq(pop(sub3, evt3)["value"].as<int32_t>(), 42);
+
+        for(auto v : {123, 124}) {
+            post(v);
+
+            testEq(pop(sub, evt)["value"].as<int32_t>(), v);
+            testEq(pop(sub2, evt2)["value"].as<int32_t>(), v);
+            auto val3(pop(sub3, evt3));
+            testEq(val3["value"].as<int32_t>(), v);
+            testFalse(val3["alarm.severity"].isMarked())<<"Only requested fields";
+        }
+    }
+};
+
 struct TestReconn : public BasicTest
 {
     void testReconn()
@@ -246,17 +298,139 @@ struct TestReconn : public BasicTest
     }
 };
 
+struct TestReady : public BasicTest
+{
+    static
+    server::Config conf()
+    {
+        auto ret(server::Config::isolated());
+        // one update per pass through the connection ready list
+        ret.tcp_tx_drain = 1u;
+        return ret;
+    }
+
+    TestReady() :BasicTest(conf()) {}
+
+    void testReady()
+    {
+        testShow()<<__func__;
+
+        serv.start();
+        mbox.open(initial);
+
+        // several subscriptions through one connection
+        constexpr size_t N = 4u;
+        epicsEvent evts[N];
+        std::shared_ptr<client::Subscription> subs[N];
+        for(size_t i=0u; i<N; i++) {
+            subs[i] = cli.monitor("mailbox")
+                        .maskConnected(true)
+                        .maskDisconnected(false)
+                        .event([&evts, i](client::Subscription& sub) {
+                            evts[i].signal();
+                        })
+                        .exec();
+        }
+
+        cli.hurryUp();
+
+        for(size_t i=0u; i<N; i++)
+            testEq(pop(subs[i], evts[i])["value"].as<int32_t>(), 42);
+
+        for(int32_t v=1; v<=10; v++)
+            post(v);
+
+        for(size_t i=0u; i<N; i++) {
+            // client may squash, but never reorder
+            int32_t last = 0;
+            bool inorder = true;
+            for(unsigned n=0u; n<10u && last!=10; n++) {
+                auto v = pop(subs[i], evts[i])["value"].as<int32_t>();
+                inorder &= v > last;
+                last = v;
+            }
+            testTrue(inorder)<<" subscription "<<i;
+            testEq(last, 10);
+        }
+    }
+};
+
+// one update shared by subscribers on different workers
+void testFanoutWorkers()
+{
+    testShow()<<__func__;
+
+    auto initial(nt::NTScalar{TypeCode::Float64A}.create());
+    auto update = [&initial](double v) {
+        shared_array<double> arr(1024u, v);
+        auto ret(initial.cloneEmpty());
+        ret["value"] = arr.freeze();
+        return ret;
+    };
+
+    auto mbox(server::SharedPV::buildReadonly());
+    mbox.open(update(0.0));
+
+    auto sconf(server::Config::isolated());
+    sconf.workers = 4u;
+    auto serv = sconf.build()
+            .addPV("mailbox", mbox)
+            .start();
+
+    // one connection per Context, spread across the workers
+    constexpr size_t N = 8u;
+    std::vector<client::Context> clis;
+    epicsEvent evts[N];
+    std::shared_ptr<client::Subscription> subs[N];
+    for(size_t i=0u; i<N; i++) {
+        clis.push_back(serv.clientConfig().build());
+        subs[i] = clis.back().monitor("mailbox")
+                    .maskConnected(true)
+                    .maskDisconnected(false)
+                    .event([&evts, i](client::Subscription& sub) {
+                        evts[i].signal();
+                    })
+                    .exec();
+        clis.back().hurryUp();
+    }
+
+    for(size_t i=0u; i<N; i++)
+        (void)BasicTest::pop(subs[i], evts[i]);
+
+    const double last = 100.0;
+    for(double v=1.0; v<=last; v+=1.0)
+        mbox.post(update(v));
+
+    bool ok = true;
+    for(size_t i=0u; i<N; i++) {
+        double prev = 0.0;
+        for(unsigned n=0u; n<100u && prev!=last; n++) {
+            auto arr(BasicTest::pop(subs[i], evts[i])["value"].as<shared_array<const double>>());
+            ok &= arr.size()==1024u && arr[0]>prev && arr[1023]==arr[0];
+            prev = arr.size() ? arr[0] : last;
+        }
+        ok &= prev==last;
+    }
+    testTrue(ok)<<" all subscribers receive all updates in order";
+
+    for(auto& sub : subs)
+        sub.reset();
+}
+
 } // namespace
 
 MAIN(testmon)
 {
-    testPlan(22);
+    testPlan(49);
     testSetup();
     logger_config_env();
     TestLifeCycle().testBasic(true);
     TestLifeCycle().testBasic(false);
     TestLifeCycle().testSecond();
     TestReconn().testReconn();
+    TestFanout().testFanout();
+    TestReady().testReady();
+    testFanoutWorkers();
     cleanup_for_valgrind();
     return testDone();
 }
@@ -0,0 +1,150 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * pvxs is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <atomic>
+
+#include <testMain.h>
+
+#include <epicsUnitTest.h>
+#include <epicsThread.h>
+
+#include <pvxs/unittest.h>
+#include <spscring.h>
+
+using namespace pvxs;
+using namespace pvxs::impl;
+namespace  {
+
+void testFIFO()
+{
+    testDiag("%s", __func__);
+
+    SPSCRing<int> Q(3u);
+    testEq(Q.capacity(), 3u);
+    testOk1(Q.empty());
+
+    int v = -1;
+    testOk1(!Q.pop(v));
+
+    // fill, and go around a few times
+    int next = 0, expect = 0;
+    bool ok = true;
+    for(unsigned round=0u; round<5u; round++) {
+        for(unsigned i=0u; i<3u; i++) {
+            int x = next++;
+            ok &= Q.push(x);
+        }
+        int x = 42;
+        ok &= !Q.push(x) && x==42 && Q.size()==3u;
+        for(unsigned i=0u; i<3u; i++) {
+            ok &= Q.pop(v) && v==expect++;
+        }
+        ok &= Q.empty();
+    }
+    testOk(ok, "FIFO order through wrap around");
+
+    testThrows<std::length_error>([&Q]() {
+        Q.reset(~size_t(0u));
+    });
+}
+
+void testUnpush()
+{
+    testDiag("%s", __func__);
+
+    SPSCRing<int> Q(2u);
+    int v = -1;
+    testOk1(!Q.unpush(v));
+
+    testOk1(Q.push(1));
+    testOk1(Q.push(2));
+    testOk1(Q.unpush(v));
+    testEq(v, 2);
+    testEq(Q.size(), 1u);
+
+    // squash as MonitorOp does
+    testOk1(Q.push(v+10));
+    testOk1(Q.pop(v));
+    testEq(v, 1);
+    testOk1(Q.pop(v));
+    testEq(v, 12);
+    testOk1(Q.empty());
+}
+
+// producer squashes into the newest entry when full.
+// consumer must see strictly increasing values, ending with the last.
+struct Consumer : public epicsThreadRunable
+{
+    SPSCRing<size_t>& Q;
+    const size_t last;
+    std::atomic<bool> ok{true};
+    size_t received = 0u;
+    epicsThread worker;
+
+    Consumer(SPSCRing<size_t>& Q, size_t last)
+        :Q(Q)
+        ,last(last)
+        ,worker(*this, "consumer", epicsThreadGetStackSize(epicsThreadStackSmall))
+    {
+        worker.start();
+    }
+
+    virtual void run() override final
+    {
+        size_t prev = 0u, v;
+        while(true) {
+            if(!Q.pop(v)) {
+                epicsThreadSleep(0.0);
+                continue;
+            }
+            received++;
+            if(v<=prev)
+                ok = false;
+            prev = v;
+            if(v==last)
+                break;
+        }
+    }
+};
+
+void testThreaded()
+{
+    testDiag("%s", __func__);
+
+    const size_t N = 200000u;
+    SPSCRing<size_t> Q(4u);
+    Consumer C(Q, N);
+
+    size_t squashed = 0u;
+    for(size_t i=1u; i<=N; i++) {
+        if(i%1024u==0u)
+            epicsThreadSleep(0.0); // let the consumer run, even with one CPU
+        size_t v = i;
+        if(!Q.push(v)) {
+            size_t prev;
+            if(Q.unpush(prev))
+                squashed++;
+            (void)Q.push(v);
+        }
+    }
+
+    C.worker.exitWait();
+    testOk(C.ok.load(), "Received in order.  %zu received, %zu squashed", C.received, squashed);
+    testOk1(Q.empty());
+}
+
+} // namespace
+
+MAIN(testring)
+{
+    testPlan(19);
+    testSetup();
+    testFIFO();
+    testUnpush();
+    testThreaded();
+    cleanup_for_valgrind();
+    return testDone();
+}
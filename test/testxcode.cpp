@@ -12,6 +12,7 @@
 #include <pvxs/nt.h>
 #include "dataimpl.h"
 #include "pvaproto.h"
+#include "evhelper.h"
 
 namespace {
 using namespace pvxs;
@@ -221,6 +222,96 @@ void testSimpleDef()
     );
 }
 
+void testTypeCache()
+{
+    testDiag("%s", __func__);
+
+    auto val1 = simpledef.create();
+    auto val2 = nt::NTScalar{TypeCode::Int32}.create();
+    std::string expect1(SB()<<Value::Helper::desc(val1));
+    std::string expect2(SB()<<Value::Helper::desc(val2));
+
+    TxTypeStore txcache;
+    std::vector<uint8_t> buf;
+    {
+        VectorOutBuf S(true, buf);
+        to_wire(S, Value::Helper::type(val1), txcache);
+        to_wire(S, Value::Helper::type(val2), txcache);
+        to_wire(S, Value::Helper::type(val1), txcache); // repeat
+        // equivalent, but not the same instance
+        to_wire(S, Value::Helper::type(nt::NTScalar{TypeCode::Int32}.create()), txcache);
+        to_wire(S, std::shared_ptr<const FieldDesc>(), txcache);
+        testOk1(S.good());
+        buf.resize(S.consumed());
+    }
+    testEq(txcache.size(), 2u);
+    testEq(txcache.byDesc.size(), 3u);
+
+    testEq(buf[0], 0xfd);
+    testEq(buf[1], 0);
+    testEq(buf[2], 0);
+    testEq(buf[buf.size()-7u], 0xfe);
+    testEq(buf[buf.size()-6u], 0);
+    testEq(buf[buf.size()-5u], 0);
+    testEq(buf[buf.size()-4u], 0xfe);
+    testEq(buf[buf.size()-3u], 0);
+    testEq(buf[buf.size()-2u], 1);
+    testEq(buf[buf.size()-1u], 0xff);
+
+    TypeStore rxcache;
+    FixedBuf S(true, buf);
+    for(auto expect : {expect1, expect2, expect1, expect2}) {
+        Value val;
+        from_wire_type(S, rxcache, val);
+        testOk1(S.good());
+        testStrEq(std::string(SB()<<Value::Helper::desc(val)), expect);
+    }
+    Value val;
+    from_wire_type(S, rxcache, val);
+    testOk(S.good() && S.empty() && !val, "Null type");
+}
+
+void testTypeIntern()
+{
+    testDiag("%s", __func__);
+
+    auto val1 = simpledef.create();
+    auto val2 = nt::NTScalar{TypeCode::Int32}.create();
+
+    std::vector<uint8_t> buf;
+    {
+        VectorOutBuf S(true, buf);
+        to_wire(S, Value::Helper::desc(val1));
+        to_wire(S, Value::Helper::desc(val2));
+        testOk1(S.good());
+        buf.resize(S.consumed());
+    }
+
+    // decode twice, as if from two different connections
+    Value rx[2][2];
+    for(auto i : range(2)) {
+        TypeStore rxcache;
+        FixedBuf S(true, buf);
+        from_wire_type(S, rxcache, rx[i][0]);
+        from_wire_type(S, rxcache, rx[i][1]);
+        testOk1(S.good() && S.empty());
+    }
+
+    testOk1(rx[0][0].compareType(rx[1][0]));
+    testOk1(rx[0][1].compareType(rx[1][1]));
+    testOk1(!rx[0][0].compareType(rx[0][1]));
+    // local types are not interned
+    testOk1(!rx[0][0].compareType(val1));
+
+    auto before = intern_type_count();
+    testOk(before>=2u, "intern count %zu", before);
+    for(auto& pair : rx) {
+        pair[0] = Value();
+        pair[1] = Value();
+    }
+    testEq(intern_type_count(), before-2u);
+}
+
 void testSerialize2()
 {
     testDiag("%s", __func__);
@@ -554,6 +645,209 @@ void testArrayXCode()
     testArrayXCodeT<std::string>("\x01\x02\x02\x05hello\x05world", {"hello", "world"});
 }
 
+// arrays long enough to exercise the bulk copy/swap path, including a partial
+// vector at the end and elements straddling evbuffer segments.
+template<typename E>
+void testArrayBulkT(bool be)
+{
+    testDiag("%s<%s>(%c)", __func__, TypeCode(ScalarMap<E>::code).name(), be ? 'B' : 'L');
+
+    shared_array<E> arr(1001u);
+    for(auto i : range(arr.size()))
+        arr[i] = E(i*3u + 1u);
+    auto expected(arr.freeze());
+
+    auto code = TypeCode(ScalarMap<E>::code).arrayOf();
+    TypeDef def(TypeCode::Struct, {Member(code, "value")});
+
+    // reference encoding, one element at a time
+    std::vector<uint8_t> ref;
+    {
+        VectorOutBuf S(be, ref);
+        to_wire(S, uint8_t(1u));
+        to_wire(S, uint8_t(2u));
+        to_wire(S, Size{expected.size()});
+        for(auto& e : expected)
+            to_wire(S, e);
+        ref.resize(ref.size()-S.size());
+    }
+
+    std::vector<uint8_t> actual;
+    {
+        auto val = def.create();
+        val["value"] = expected;
+        VectorOutBuf S(be, actual);
+        to_wire_valid(S, val);
+        testOk1(S.good());
+        actual.resize(actual.size()-S.size());
+    }
+    testOk(actual==ref, "Encoded %u bytes, expected %u",
+           unsigned(actual.size()), unsigned(ref.size()));
+
+    // split into odd sized segments
+    evbuf backing(evbuffer_new());
+    for(size_t pos=0; pos<ref.size(); pos+=13u) {
+        auto n = std::min(size_t(13u), ref.size()-pos);
+        evbuffer_add_reference(backing.get(), &ref[pos], n, nullptr, nullptr);
+    }
+
+    TypeStore ctxt;
+    auto val2 = def.create();
+    {
+        EvInBuf S(be, backing.get());
+        from_wire_valid(S, ctxt, val2);
+        testOk1(S.good());
+    }
+    testEq(evbuffer_get_length(backing.get()), 0u);
+    testArrEq(expected, val2["value"].as<shared_array<const E>>());
+}
+
+void testArrayBulk()
+{
+    for(auto be : {true, false}) {
+        testArrayBulkT<int8_t>(be);
+        testArrayBulkT<uint16_t>(be);
+        testArrayBulkT<int32_t>(be);
+        testArrayBulkT<float>(be);
+        testArrayBulkT<uint64_t>(be);
+        testArrayBulkT<double>(be);
+    }
+}
+
+// large arrays in a single evbuffer chain are referenced in place
+template<typename E>
+void testArrayDetachT(bool be, bool expectInPlace)
+{
+    testDiag("%s<%s>(%c)", __func__, TypeCode(ScalarMap<E>::code).name(), be ? 'B' : 'L');
+
+    TypeDef def(TypeCode::Struct, {
+                    Member(TypeCode(ScalarMap<E>::code).arrayOf(), "value"),
+                    Member(TypeCode::Int32, "after"),
+                });
+
+    shared_array<E> arr(4000u);
+    for(auto i : range(arr.size()))
+        arr[i] = E(i);
+    auto expected(arr.freeze());
+
+    std::vector<uint8_t> encoded;
+    {
+        auto val = def.create();
+        val["value"] = expected;
+        val["after"] = 42;
+        VectorOutBuf S(be, encoded);
+        to_wire_valid(S, val);
+        encoded.resize(encoded.size()-S.size());
+    }
+
+    evbuf backing(evbuffer_new());
+    evbuffer_add_reference(backing.get(), encoded.data(), encoded.size(), nullptr, nullptr);
+
+    TypeStore ctxt;
+    auto val2 = def.create();
+    {
+        EvInBuf S(be, backing.get());
+        from_wire_valid(S, ctxt, val2);
+        testOk1(S.good());
+    }
+    testEq(evbuffer_get_length(backing.get()), 0u);
+
+    auto actual(val2["value"].as<shared_array<const E>>());
+    testOk1(actual.size()==expected.size() && std::equal(actual.begin(), actual.end(), expected.begin()));
+    testEq(val2["after"].as<int32_t>(), 42);
+
+    auto ptr = reinterpret_cast<const uint8_t*>(actual.data());
+    bool inplace = ptr>=encoded.data() && ptr<encoded.data()+encoded.size();
+    testEq(inplace, expectInPlace);
+}
+
+void testArrayDetach()
+{
+    testArrayDetachT<uint8_t>(hostBE, true);
+    testArrayDetachT<uint8_t>(!hostBE, true);
+    // byte order must be swapped
+    testArrayDetachT<uint16_t>(!hostBE, false);
+}
+
+// large arrays are appended to an evbuffer by reference
+void testArrayReference()
+{
+    testDiag("%s", __func__);
+
+    TypeDef def(TypeCode::Struct, {
+                    Member(TypeCode::Float64A, "value"),
+                    Member(TypeCode::Int32, "after"),
+                });
+
+    shared_array<double> arr(4000u);
+    for(auto i : range(arr.size()))
+        arr[i] = i*0.5;
+    auto expected(arr.freeze());
+
+    auto val = def.create();
+    val["value"] = expected;
+    val["after"] = 42;
+    // Value holds one reference
+    testEq(expected.dataPtr().use_count(), 2);
+
+    std::vector<uint8_t> encoded;
+    {
+        VectorOutBuf S(hostBE, encoded);
+        to_wire_valid(S, val);
+        encoded.resize(encoded.size()-S.size());
+    }
+
+    evbuf backing(evbuffer_new());
+    {
+        EvOutBuf S(hostBE, backing.get());
+        to_wire_valid(S, val);
+        testOk1(S.good());
+    }
+    testEq(expected.dataPtr().use_count(), 3);
+
+    std::vector<uint8_t> actual(evbuffer_get_length(backing.get()));
+    evbuffer_copyout(backing.get(), actual.data(), actual.size());
+    testOk1(actual==encoded);
+
+    backing.reset();
+    testEq(expected.dataPtr().use_count(), 2);
+}
+
+// after a failed detach(), reading continues where it left off
+void testDetachFallback()
+{
+    testDiag("%s", __func__);
+
+    std::vector<uint8_t> first(3000u), second(100u);
+    for(auto i : range(first.size()))
+        first[i] = uint8_t(i);
+    for(auto i : range(second.size()))
+        second[i] = uint8_t(0x80u + i);
+
+    // two chains
+    evbuf backing(evbuffer_new());
+    evbuffer_add_reference(backing.get(), first.data(), first.size(), nullptr, nullptr);
+    evbuffer_add_reference(backing.get(), second.data(), second.size(), nullptr, nullptr);
+
+    EvInBuf S(true, backing.get());
+    uint32_t head = 0u;
+    from_wire(S, head);
+
+    // spans both chains
+    testOk1(!S.detach(first.size(), 1u));
+
+    bool ok = true;
+    for(auto i : range(size_t(4u), first.size())) {
+        uint8_t b = 0u;
+        from_wire(S, b);
+        ok &= b==first[i];
+    }
+    uint8_t b = 0u;
+    from_wire(S, b);
+    ok &= b==second[0];
+    testOk(ok && S.good(), "following bytes read after detach() fails");
+}
+
 /*  epics:nt/NTScalarArray:1.0
  *      double[] value
  *      alarm_t alarm
@@ -576,6 +870,116 @@ const uint8_t NTScalar[] = "\x80\x1a""epics:nt/NTScalarArray:1.0\x03"
                                 "\x0b""nanoseconds\""
                                 "\x07""userTag\"";
 
+size_t encodedLength(const Value& val, bool full, const BitMask* mask=nullptr)
+{
+    std::vector<uint8_t> buf(16u);
+    VectorOutBuf S(true, buf);
+    if(full)
+        to_wire_full(S, val);
+    else
+        to_wire_valid(S, val, mask);
+    testOk1(S.good());
+    return S.consumed();
+}
+
+void testEncodedSize()
+{
+    testDiag("%s", __func__);
+
+    auto val = simpledef.create();
+    {
+        shared_array<uint64_t> arr(300u, 5u); // length encoded with 5 bytes
+        val["value"] = arr.freeze();
+    }
+    val["timeStamp.secondsPastEpoch"] = 1u;
+    {
+        auto fld = val["arbitrary.sarr"];
+        shared_array<Value> arr(2);
+        arr[0] = fld.allocMember();
+        arr[0]["value"] = 4u;
+        fld = arr.freeze().castTo<const void>();
+    }
+    {
+        auto v = TypeDef(TypeCode::Struct, "my_t", {Member(TypeCode::String, "q")}).create();
+        v["q"] = std::string(300u, 'x');
+        val["any"].from(v);
+    }
+    {
+        auto fld = val["anya"];
+        shared_array<Value> arr(2);
+        arr[0] = TypeDef(TypeCode::StringA).create();
+        fld = arr.freeze().castTo<const void>();
+    }
+    val["choice->b"] = "test";
+
+    testEq(encoded_size_full(val), encodedLength(val, true));
+    testEq(encoded_size_valid(val), encodedLength(val, false));
+
+    BitMask mask({1u, 2u, 7u}, Value::Helper::desc(val)->size());
+    testEq(encoded_size_valid(val, &mask), encodedLength(val, false, &mask));
+
+    // nothing marked
+    auto empty = simpledef.create();
+    testEq(encoded_size_valid(empty), encodedLength(empty, false));
+    // NULL Union and Any
+    testEq(encoded_size_full(empty), encodedLength(empty, true));
+}
+
+void testWideValid()
+{
+    testDiag("%s", __func__);
+
+    // marked flags span several words, with a sub-struct which starts mid-word
+    std::vector<Member> pad, inner;
+    for(auto i : range(100u))
+        pad.push_back(Member(TypeCode::UInt32, SB()<<"p"<<i));
+    for(auto i : range(70u))
+        inner.push_back(Member(TypeCode::UInt32, SB()<<"i"<<i));
+    TypeDef def(TypeCode::Struct, {});
+    def += pad;
+    def += {Member(TypeCode::Struct, "sub", inner)};
+
+    auto val = def.create();
+    val["p62"] = 1u;
+    val["p63"] = 2u;
+    val["sub.i0"] = 3u;
+    val["sub.i69"] = 4u;
+
+    auto sub = val["sub"];
+    testTrue(sub.isMarked(false, true));
+    {
+        std::vector<std::string> names;
+        for(auto fld : sub.imarked())
+            names.push_back(sub.nameOf(fld));
+        testEq(names.size(), 2u);
+        testTrue(names.size()==2u && names[0]=="i0" && names[1]=="i69");
+    }
+
+    // encoding of sub-struct must match a stand-alone copy
+    auto copy = sub.cloneEmpty();
+    copy.assign(sub);
+    testEq(encoded_size_valid(sub), encodedLength(copy, false));
+    {
+        std::vector<uint8_t> a, b;
+        {
+            VectorOutBuf S(true, a);
+            to_wire_valid(S, sub);
+            a.resize(a.size()-S.size());
+        }
+        {
+            VectorOutBuf S(true, b);
+            to_wire_valid(S, copy);
+            b.resize(b.size()-S.size());
+        }
+        testTrue(a==b);
+    }
+
+    sub.unmark();
+    testFalse(sub.isMarked(false, true));
+    testTrue(val["p63"].isMarked());
+    testEq(encoded_size_valid(val), encodedLength(val, false));
+}
+
 void testXCodeNTScalar()
 {
     testDiag("%s", __func__);
@@ -952,16 +1356,24 @@ void testEmptyRequest()
 
 MAIN(testxcode)
 {
-    testPlan(116);
+    testPlan(249);
     testSetup();
     testSerialize1();
     testDeserialize1();
     testSimpleDef();
+    testTypeCache();
+    testTypeIntern();
     testSerialize2();
     testDeserialize2();
     testDeserialize3();
     testDecode1();
     testArrayXCode();
+    testArrayBulk();
+    testArrayDetach();
+    testDetachFallback();
+    testArrayReference();
+    testEncodedSize();
+    testWideValid();
     testXCodeNTScalar();
     testXCodeNTNDArray();
     testEmptyRequest();